@@ -3,8 +3,22 @@
 
 #include <opencv2/opencv.hpp>
 #include <string>
+#include <vector>
 #include "Utils.h"
 
+// Precomputed statistics of one image, shared read-only by several renders
+struct ImageStatistics {
+    cv::Mat image;                      // Source in BGR, possibly downscaled
+    cv::Mat integral;                   // Summed-area table of image (CV_64FC3)
+    std::vector<Utils::Color> palette;  // Quantized palette of image
+    double scale = 1.0;                 // image size relative to the original
+
+    bool isValid() const { return !image.empty(); }
+
+    // Average color of a region in O(1) via the summed-area table
+    Utils::Color getAverageColor(const cv::Rect& region) const;
+};
+
 class ImageProcessor {
 public:
     ImageProcessor();
@@ -28,6 +42,14 @@ public:
     // Get average color of entire image
     Utils::Color getAverageColor() const;
 
+    // Precompute statistics on a copy downscaled to fit maxSize; a
+    // paletteSize of 0 skips the palette for modes that never use it
+    ImageStatistics computeStatistics(int maxSize, int paletteSize = 16);
+
+    // Dominant edge orientation per tile (radians in [0, pi), row-major),
+    // from the gradient structure tensor summed over each tile in parallel bands
+    static std::vector<float> computeTileOrientations(const cv::Mat& image, int tileSize);
+
     // Extract pixel data
     cv::Vec3b getPixel(int x, int y) const;
 
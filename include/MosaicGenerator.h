@@ -4,12 +4,16 @@
 #include <opencv2/opencv.hpp>
 #include "ImageProcessor.h"
 #include "Utils.h"
+#include <array>
 #include <vector>
 
 enum class TileShape {
     SQUARE,
     CIRCLE,
-    HEXAGON
+    HEXAGON,
+    ORIENTED_SQUARE,    // Square rotated to the local edge direction
+    ORIENTED_RECTANGLE, // Elongated tile laid along the local edge direction
+    SUPERPIXEL          // Irregular SLIC superpixel following image content
 };
 
 enum class ColorMode {
@@ -18,6 +22,27 @@ enum class ColorMode {
     QUANTIZED       // Quantized color palette
 };
 
+// Resolution-independent description of a mosaic: one color (and, for
+// oriented shapes, one edge angle) per tile, stored row-major. Superpixel
+// mosaics seed one cluster per grid tile and add a CV_8U per-pixel map of
+// neighbour-seed offsets (see SuperpixelEngine::seedIndex).
+struct MosaicGrid {
+    int width = 0;
+    int height = 0;
+    int tileSize = 0;
+    int tilesX = 0;
+    int tilesY = 0;
+    TileShape shape = TileShape::SQUARE;
+    std::vector<Utils::Color> colors;
+    std::vector<float> orientations;
+    cv::Mat labels;
+
+    bool isValid() const { return !colors.empty(); }
+
+    // Pixel bounds of a tile, clipped at the right and bottom edges
+    cv::Rect tileRect(int tx, int ty) const;
+};
+
 class MosaicGenerator {
 public:
     MosaicGenerator(ImageProcessor* processor);
@@ -27,8 +52,33 @@ public:
     cv::Mat generateMosaic(int tileSize, TileShape shape = TileShape::SQUARE, 
                           ColorMode mode = ColorMode::AVERAGE);
 
+    // Generate mosaic from precomputed statistics. tileSize is given at the
+    // original resolution and scaled to the statistics image.
+    cv::Mat generateMosaic(const ImageStatistics& stats, int tileSize,
+                           TileShape shape = TileShape::SQUARE,
+                           ColorMode mode = ColorMode::AVERAGE);
+
+    // Compute tile colors and orientations without rasterizing
+    MosaicGrid buildGrid(int tileSize, TileShape shape = TileShape::SQUARE,
+                         ColorMode mode = ColorMode::AVERAGE);
+    MosaicGrid buildGrid(const ImageStatistics& stats, int tileSize,
+                         TileShape shape = TileShape::SQUARE,
+                         ColorMode mode = ColorMode::AVERAGE);
+
+    // Rasterize a whole grid at its native resolution
+    cv::Mat renderGrid(const MosaicGrid& grid);
+
+    // Rasterize outputRect of the grid scaled by scale, without touching the
+    // rest of the mosaic. Thread-safe; used for tiled export and viewing.
+    static cv::Mat renderRegion(const MosaicGrid& grid, const cv::Rect& outputRect, double scale);
+
     // Set color palette for quantized mode
     void setColorPalette(const std::vector<Utils::Color>& palette);
+    const std::vector<Utils::Color>& getColorPalette() const { return colorPalette; }
+
+    // Diffuse quantization error across tiles (Floyd-Steinberg) in quantized mode
+    void setDithering(bool enabled) { dithering = enabled; }
+    bool isDithering() const { return dithering; }
 
     // Generate mosaic with custom tile patterns
     cv::Mat generatePatternMosaic(int tileSize, const std::vector<cv::Mat>& tilePatterns);
@@ -41,11 +91,24 @@ private:
     ImageProcessor* imageProcessor;
     int tilesX, tilesY;
     std::vector<Utils::Color> colorPalette;
+    bool dithering;
+
+    // Oriented tiles snap to one of this many angles over [0, 180) degrees
+    static constexpr int ORIENTATION_BINS = 32;
+    using OrientedCorners = std::array<cv::Point2d, 4>;
 
     // Helper methods
-    cv::Mat drawSquareTile(const cv::Size& size, const Utils::Color& color);
-    cv::Mat drawCircleTile(const cv::Size& size, const Utils::Color& color);
-    cv::Mat drawHexagonTile(const cv::Size& size, const Utils::Color& color);
+    MosaicGrid computeGrid(const cv::Mat& sourceImage, const ImageStatistics* stats, int tileSize,
+                           TileShape shape, ColorMode mode, const std::vector<Utils::Color>& palette);
+    static cv::Mat drawRegion(const MosaicGrid& grid, const cv::Rect& outputRect, double scale);
+    static void ditherColors(std::vector<Utils::Color>& colors, int tilesX, int tilesY,
+                             const std::vector<Utils::Color>& palette);
+    static void drawSuperpixels(const MosaicGrid& grid, cv::Mat& output,
+                                const cv::Rect& outputRect, double scale);
+    static bool isOriented(TileShape shape);
+    static cv::Size2f orientedBox(TileShape shape, double tileSize);
+    static std::vector<OrientedCorners> orientedCorners(const cv::Size2f& box);
+    static int orientationBin(float angle);
     Utils::Color findClosestColor(const Utils::Color& target, const std::vector<Utils::Color>& palette);
 };
 
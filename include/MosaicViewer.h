@@ -0,0 +1,64 @@
+#ifndef MOSAICVIEWER_H
+#define MOSAICVIEWER_H
+
+#include <QtWidgets/QGraphicsView>
+#include <QtWidgets/QGraphicsScene>
+#include <QtCore/QCache>
+#include <QtCore/QSet>
+#include <QtCore/QThreadPool>
+#include <QtGui/QImage>
+#include "MosaicGenerator.h"
+#include <memory>
+
+class MosaicTileItem;
+
+// Zoomable, pannable mosaic view. Only the tiles visible at the current zoom
+// level are rasterized, in the background, straight from the MosaicGrid, and
+// recently used tiles are kept in a bounded cache.
+class MosaicViewer : public QGraphicsView {
+    Q_OBJECT
+
+public:
+    MosaicViewer(QWidget* parent = nullptr);
+    ~MosaicViewer();
+
+    // Show a new mosaic; keeps the current zoom if the size is unchanged
+    void setGrid(const MosaicGrid& grid);
+
+    // Drop the mosaic, e.g. when it no longer matches the loaded image
+    void clear();
+
+    void fitToView();
+
+    static constexpr int VIEW_TILE_SIZE = 256;
+
+protected:
+    void wheelEvent(QWheelEvent* event) override;
+
+private:
+    friend class MosaicTileItem;
+
+    // Cached view tile, or nullptr after scheduling a background render
+    const QImage* requestTile(int level, int col, int row);
+    const QImage* findTile(int level, int col, int row) const;
+    void onTileReady(int generation, quint64 key, const QImage& image);
+    void onLevelChanged(int level);
+    int maxLevel() const;
+
+    static quint64 tileKey(int level, int col, int row);
+
+    QGraphicsScene* scene;
+    MosaicTileItem* tileItem;
+    std::shared_ptr<const MosaicGrid> currentGrid;
+
+    QCache<quint64, QImage> tileCache;
+    QSet<quint64> pendingTiles;
+    QThreadPool renderPool;
+    int generation;
+    int currentLevel;
+
+    static constexpr int MIN_LEVEL = -3;            // Up to 8x magnified rendering
+    static constexpr int CACHE_LIMIT_KB = 128 * 1024;
+};
+
+#endif // MOSAICVIEWER_H
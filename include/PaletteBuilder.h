@@ -0,0 +1,49 @@
+#ifndef PALETTEBUILDER_H
+#define PALETTEBUILDER_H
+
+#include <opencv2/opencv.hpp>
+#include "Utils.h"
+#include <string>
+#include <vector>
+
+// Builds one palette shared by a whole collection of images. Pixels are
+// streamed into a fixed-size reservoir sample, so memory does not grow with
+// the collection, and each added image refines the existing palette instead
+// of clustering everything again.
+class PaletteBuilder {
+public:
+    PaletteBuilder(int paletteSize = 16, int sampleBudget = 65536);
+    ~PaletteBuilder();
+
+    // Stream an image into the sample and refine the palette
+    bool addImage(const std::string& filepath);
+    bool addImage(const cv::Mat& image);
+
+    // Persist and restore the palette together with its sample
+    bool save(const std::string& filepath) const;
+    bool load(const std::string& filepath);
+
+    const std::vector<Utils::Color>& getPalette() const { return palette; }
+    int getImageCount() const { return imageCount; }
+    long long getPixelsSeen() const { return pixelsSeen; }
+    bool hasPalette() const { return !palette.empty(); }
+
+private:
+    void samplePixels(const cv::Mat& image);
+    void refinePalette();
+
+    int paletteSize;
+    int sampleBudget;
+    cv::Mat reservoir;                  // sampleBudget x 1, CV_8UC3 (BGR)
+    int sampleCount;
+    long long pixelsSeen;
+    int imageCount;
+    double skipWeight;                  // Reservoir skip state (Algorithm L)
+    long long nextReplacement;          // Stream index of the next sampled pixel
+    std::vector<Utils::Color> palette;
+    cv::RNG rng;                        // Saved so later sessions continue the stream
+
+    static constexpr int REFINE_ITERATIONS = 5;
+};
+
+#endif // PALETTEBUILDER_H
@@ -0,0 +1,71 @@
+#ifndef PARAMETERSWEEPDIALOG_H
+#define PARAMETERSWEEPDIALOG_H
+
+#include <QtWidgets/QDialog>
+#include <QtWidgets/QGridLayout>
+#include <QtWidgets/QPushButton>
+#include <QtWidgets/QButtonGroup>
+#include <QtWidgets/QLabel>
+#include <QtWidgets/QProgressBar>
+#include <QtCore/QThreadPool>
+#include <QtGui/QImage>
+#include "ImageProcessor.h"
+#include "MosaicGenerator.h"
+#include <atomic>
+#include <vector>
+
+// Contact sheet of preview-resolution mosaics across tile sizes and shapes.
+// Every variant is rendered concurrently from one shared ImageStatistics.
+class ParameterSweepDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    ParameterSweepDialog(ImageProcessor* processor, ColorMode mode, bool dithering,
+                         const std::vector<Utils::Color>& palette, QWidget* parent = nullptr);
+    ~ParameterSweepDialog();
+
+    // Selection to promote to a full-resolution render
+    int selectedTileSize() const { return selectedIndex >= 0 ? variants[selectedIndex].tileSize : 0; }
+    TileShape selectedShape() const { return selectedIndex >= 0 ? variants[selectedIndex].shape : TileShape::SQUARE; }
+
+public slots:
+    void done(int result) override;
+
+private slots:
+    void onVariantClicked(int index);
+
+private:
+    struct Variant {
+        int tileSize;
+        TileShape shape;
+        const char* shapeName;
+        QPushButton* button;
+    };
+
+    void setupUI();
+    void startRendering();
+    void setThumbnail(int index, const QImage& thumbnail);
+    static QImage toThumbnail(const cv::Mat& mosaic);
+
+    QGridLayout* sheetLayout;
+    QButtonGroup* variantGroup;
+    QProgressBar* progressBar;
+    QPushButton* renderButton;
+    QLabel* selectionLabel;
+
+    ImageStatistics statistics;
+    ColorMode colorMode;
+    bool dithering;
+    std::vector<Utils::Color> colorPalette;
+    std::vector<Variant> variants;
+    int selectedIndex;
+
+    QThreadPool workerPool;
+    std::atomic<bool> cancelled;
+
+    static constexpr int STATISTICS_MAX_SIZE = 800;
+    static constexpr int STATISTICS_PALETTE_SIZE = 16;
+    static constexpr int THUMBNAIL_SIZE = 180;
+};
+
+#endif // PARAMETERSWEEPDIALOG_H
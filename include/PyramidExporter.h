@@ -0,0 +1,33 @@
+#ifndef PYRAMIDEXPORTER_H
+#define PYRAMIDEXPORTER_H
+
+#include "MosaicGenerator.h"
+#include <functional>
+#include <string>
+
+// Writes a mosaic as a Deep Zoom (DZI) tile pyramid. Every pyramid tile is
+// rendered straight from the MosaicGrid and encoded on its own worker, so the
+// full-resolution raster is never held in memory.
+class PyramidExporter {
+public:
+    // Reports finished tiles; called from worker threads. Return false to cancel.
+    using ProgressCallback = std::function<bool(int done, int total)>;
+
+    PyramidExporter(int tileSize = 256, const std::string& format = "jpg");
+    ~PyramidExporter();
+
+    // Write <name>.dzi and the <name>_files/<level>/<col>_<row> tiles beside it
+    bool exportDeepZoom(const MosaicGrid& grid, const std::string& dziPath,
+                        const ProgressCallback& progress = nullptr);
+
+    int getTileSize() const { return tileSize; }
+    const std::string& getFormat() const { return format; }
+
+private:
+    int tileSize;
+    std::string format;
+
+    static constexpr int JPEG_QUALITY = 90;
+};
+
+#endif // PYRAMIDEXPORTER_H
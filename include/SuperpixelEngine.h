@@ -0,0 +1,35 @@
+#ifndef SUPERPIXELENGINE_H
+#define SUPERPIXELENGINE_H
+
+#include <opencv2/opencv.hpp>
+#include "Utils.h"
+#include <vector>
+
+// SLIC-style superpixel clustering in Lab space. Clusters are seeded on a
+// regular grid and each pixel only competes for the 3x3 neighbouring seeds,
+// so assignment runs row-parallel with contiguous, vectorizable inner loops.
+class SuperpixelEngine {
+public:
+    SuperpixelEngine(int iterations = 5, double compactness = 20.0);
+    ~SuperpixelEngine();
+
+    // Cluster image into superpixels seeded every `spacing` pixels. Returns a
+    // CV_8U label map and fills the mean color of each cluster. Every pixel
+    // belongs to one of the 3x3 seeds around its own seed cell, so the map
+    // stores only that neighbour offset (0-8); seedIndex recovers the seed.
+    cv::Mat segment(const cv::Mat& image, int spacing, std::vector<Utils::Color>& meanColors) const;
+
+    // Row-major seed index of pixel (x, y) from its label map entry
+    static int seedIndex(int x, int y, int offset, int spacing, int seedsX) {
+        return (y / spacing + offset / 3 - 1) * seedsX + x / spacing + offset % 3 - 1;
+    }
+
+    int getIterations() const { return iterations; }
+    double getCompactness() const { return compactness; }
+
+private:
+    int iterations;
+    double compactness;
+};
+
+#endif // SUPERPIXELENGINE_H
@@ -9,13 +9,21 @@
 #include <QtWidgets/QLabel>
 #include <QtWidgets/QSpinBox>
 #include <QtWidgets/QComboBox>
+#include <QtWidgets/QCheckBox>
 #include <QtWidgets/QFileDialog>
 #include <QtWidgets/QSlider>
+#include <QtWidgets/QProgressDialog>
+#include <QtCore/QThreadPool>
 #include <QtGui/QPixmap>
 #include <QtGui/QImage>
 #include "ImageProcessor.h"
 #include "MosaicGenerator.h"
+#include "MosaicViewer.h"
 #include <opencv2/opencv.hpp>
+#include <atomic>
+#include <memory>
+
+class PaletteBuilder;
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -28,13 +36,22 @@ private slots:
     void onLoadImage();
     void onGenerateMosaic();
     void onSaveMosaic();
+    void onExploreParameters();
+    void onExportDeepZoom();
+    void onBuildCollectionPalette();
+    void onClearCollectionPalette();
     void onTileSizeChanged(int value);
     void onShapeChanged(int index);
     void onColorModeChanged(int index);
+    void onDitheringToggled(bool checked);
 
 private:
     void setupUI();
     void updatePreview();
+    void onExportFinished(QProgressDialog* progressDialog, bool success);
+    void onCollectionPaletteFinished(QProgressDialog* progressDialog, std::shared_ptr<PaletteBuilder> builder,
+                                     int total, const QStringList& failedFiles, bool saved);
+    void applyCollectionPalette(const PaletteBuilder& builder);
     QImage matToQImage(const cv::Mat& mat);
 
     // UI Components
@@ -43,12 +60,17 @@ private:
     
     // Image display
     QLabel* originalImageLabel;
-    QLabel* mosaicImageLabel;
+    MosaicViewer* mosaicViewer;
     
     // Controls
     QPushButton* loadImageButton;
     QPushButton* generateButton;
     QPushButton* saveButton;
+    QPushButton* exploreButton;
+    QPushButton* exportButton;
+    QPushButton* paletteButton;
+    QPushButton* clearPaletteButton;
+    QLabel* paletteLabel;
     
     QSpinBox* tileSizeSpinBox;
     QLabel* tileSizeLabel;
@@ -59,10 +81,22 @@ private:
     QComboBox* colorModeComboBox;
     QLabel* colorModeLabel;
     
+    QCheckBox* ditherCheckBox;
+    
     // Data
     ImageProcessor* imageProcessor;
     MosaicGenerator* mosaicGenerator;
-    cv::Mat currentMosaic;
+    MosaicGrid currentGrid;
+    
+    // Deep zoom export runs on its own thread so the window stays responsive
+    QThreadPool exportPool;
+    std::atomic<bool> exportCancelled;
+    bool exportRunning;
+    
+    // Collection palettes are built on a worker for the same reason
+    QThreadPool palettePool;
+    std::atomic<bool> paletteCancelled;
+    bool paletteRunning;
     
     static constexpr int PREVIEW_MAX_SIZE = 800;
 };
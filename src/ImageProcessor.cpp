@@ -1,6 +1,9 @@
 #include "../include/ImageProcessor.h"
 #include <opencv2/imgproc.hpp>
 #include <opencv2/imgcodecs.hpp>
+#include <opencv2/core/utility.hpp>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 ImageProcessor::ImageProcessor() {
@@ -79,6 +82,117 @@ Utils::Color ImageProcessor::getAverageColor() const {
     );
 }
 
+ImageStatistics ImageProcessor::computeStatistics(int maxSize, int paletteSize) {
+    ImageStatistics stats;
+    if (currentImage.empty()) {
+        return stats;
+    }
+
+    stats.image = resizeImage(currentImage, maxSize, maxSize);
+    stats.scale = static_cast<double>(stats.image.cols) / currentImage.cols;
+    cv::integral(stats.image, stats.integral, CV_64F);
+    if (paletteSize > 0) {
+        stats.palette = Utils::quantizeColors(stats.image, paletteSize);
+    }
+    return stats;
+}
+
+std::vector<float> ImageProcessor::computeTileOrientations(const cv::Mat& image, int tileSize) {
+    if (image.empty() || tileSize <= 0) {
+        return {};
+    }
+
+    const int width = image.cols;
+    const int height = image.rows;
+    const int tilesX = (width + tileSize - 1) / tileSize;
+    const int tilesY = (height + tileSize - 1) / tileSize;
+    std::vector<float> orientations(static_cast<size_t>(tilesX) * tilesY, 0.0f);
+
+    // The tensor is integrated directly over each tile, so the only smoothing
+    // is a small fixed pre-blur against pixel noise. Each band carries a halo
+    // covering that blur and the Sobel support, so band seams match a
+    // full-frame pass while only a few hundred rows are resident per thread.
+    const int blurRadius = 2;
+    const cv::Size blurKernel(2 * blurRadius + 1, 2 * blurRadius + 1);
+    const int halo = blurRadius + 1;
+    const int tileRowsPerBand = std::max(1, 256 / tileSize);
+    const int bandCount = (tilesY + tileRowsPerBand - 1) / tileRowsPerBand;
+
+    cv::parallel_for_(cv::Range(0, bandCount), [&](const cv::Range& range) {
+        cv::Mat gray, dx, dy, jxx, jxy, jyy;
+
+        for (int band = range.start; band < range.end; ++band) {
+            int firstTileRow = band * tileRowsPerBand;
+            int lastTileRow = std::min(tilesY, firstTileRow + tileRowsPerBand);
+            int y0 = firstTileRow * tileSize;
+            int y1 = std::min(height, lastTileRow * tileSize);
+            int bandTop = std::max(0, y0 - halo);
+            int bandBottom = std::min(height, y1 + halo);
+
+            cv::Mat bandImage = image.rowRange(bandTop, bandBottom);
+            if (bandImage.channels() == 3) {
+                cv::cvtColor(bandImage, gray, cv::COLOR_BGR2GRAY);
+            } else {
+                bandImage.copyTo(gray);
+            }
+
+            // Separable, SIMD-backed OpenCV filters do the heavy lifting
+            cv::GaussianBlur(gray, gray, blurKernel, 1.0, 1.0, cv::BORDER_REPLICATE);
+            cv::Sobel(gray, dx, CV_32F, 1, 0, 3, 1.0, 0.0, cv::BORDER_REPLICATE);
+            cv::Sobel(gray, dy, CV_32F, 0, 1, 3, 1.0, 0.0, cv::BORDER_REPLICATE);
+            cv::multiply(dx, dx, jxx);
+            cv::multiply(dx, dy, jxy);
+            cv::multiply(dy, dy, jyy);
+
+            for (int ty = firstTileRow; ty < lastTileRow; ++ty) {
+                int rowTop = ty * tileSize - bandTop;
+                int rowBottom = std::min(height, (ty + 1) * tileSize) - bandTop;
+
+                for (int tx = 0; tx < tilesX; ++tx) {
+                    int x = tx * tileSize;
+                    cv::Rect cell(x, rowTop, std::min(tileSize, width - x), rowBottom - rowTop);
+                    double sxx = cv::sum(jxx(cell))[0];
+                    double sxy = cv::sum(jxy(cell))[0];
+                    double syy = cv::sum(jyy(cell))[0];
+
+                    // Dominant gradient direction, turned 90 degrees to follow the edge
+                    double angle = 0.5 * std::atan2(2.0 * sxy, sxx - syy) + CV_PI / 2.0;
+                    if (angle >= CV_PI) {
+                        angle -= CV_PI;
+                    } else if (angle < 0.0) {
+                        angle += CV_PI;
+                    }
+                    orientations[static_cast<size_t>(ty) * tilesX + tx] = static_cast<float>(angle);
+                }
+            }
+        }
+    }, bandCount);
+
+    return orientations;
+}
+
+Utils::Color ImageStatistics::getAverageColor(const cv::Rect& region) const {
+    if (integral.empty() || region.area() <= 0 ||
+        region.x < 0 || region.y < 0 ||
+        region.x + region.width > image.cols ||
+        region.y + region.height > image.rows) {
+        return Utils::Color(0, 0, 0);
+    }
+
+    const cv::Vec3d& tl = integral.at<cv::Vec3d>(region.y, region.x);
+    const cv::Vec3d& tr = integral.at<cv::Vec3d>(region.y, region.x + region.width);
+    const cv::Vec3d& bl = integral.at<cv::Vec3d>(region.y + region.height, region.x);
+    const cv::Vec3d& br = integral.at<cv::Vec3d>(region.y + region.height, region.x + region.width);
+    cv::Vec3d sum = br - tr - bl + tl;
+    double area = static_cast<double>(region.area());
+
+    return Utils::Color(
+        static_cast<int>(sum[2] / area), // BGR to RGB
+        static_cast<int>(sum[1] / area),
+        static_cast<int>(sum[0] / area)
+    );
+}
+
 cv::Vec3b ImageProcessor::getPixel(int x, int y) const {
     if (currentImage.empty() || 
         x < 0 || x >= currentImage.cols ||
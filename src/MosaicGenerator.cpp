@@ -1,28 +1,45 @@
 #include "../include/MosaicGenerator.h"
+#include "../include/SuperpixelEngine.h"
 #include <opencv2/imgproc.hpp>
+#include <opencv2/core/utility.hpp>
 #include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <climits>
 #include <cmath>
+#include <cstdint>
+#include <thread>
 
 MosaicGenerator::MosaicGenerator(ImageProcessor* processor) 
-    : imageProcessor(processor), tilesX(0), tilesY(0) {
+    : imageProcessor(processor), tilesX(0), tilesY(0), dithering(false) {
 }
 
 MosaicGenerator::~MosaicGenerator() {
 }
 
 cv::Mat MosaicGenerator::generateMosaic(int tileSize, TileShape shape, ColorMode mode) {
-    if (!imageProcessor || !imageProcessor->isImageLoaded()) {
+    MosaicGrid grid = buildGrid(tileSize, shape, mode);
+    if (!grid.isValid()) {
         return cv::Mat();
     }
+    return renderGrid(grid);
+}
 
-    cv::Mat sourceImage = imageProcessor->getImage();
-    int width = sourceImage.cols;
-    int height = sourceImage.rows;
+cv::Mat MosaicGenerator::generateMosaic(const ImageStatistics& stats, int tileSize,
+                                        TileShape shape, ColorMode mode) {
+    MosaicGrid grid = buildGrid(stats, tileSize, shape, mode);
+    if (!grid.isValid()) {
+        return cv::Mat();
+    }
+    return renderGrid(grid);
+}
 
-    tilesX = (width + tileSize - 1) / tileSize;
-    tilesY = (height + tileSize - 1) / tileSize;
+MosaicGrid MosaicGenerator::buildGrid(int tileSize, TileShape shape, ColorMode mode) {
+    if (!imageProcessor || !imageProcessor->isImageLoaded() || tileSize <= 0) {
+        return MosaicGrid();
+    }
 
-    cv::Mat mosaic = cv::Mat::zeros(height, width, CV_8UC3);
+    cv::Mat sourceImage = imageProcessor->getImage();
 
     // Prepare color palette if quantized mode
     std::vector<Utils::Color> palette = colorPalette;
@@ -30,55 +47,211 @@ cv::Mat MosaicGenerator::generateMosaic(int tileSize, TileShape shape, ColorMode
         palette = Utils::quantizeColors(sourceImage, 16);
     }
 
-    for (int ty = 0; ty < tilesY; ++ty) {
-        for (int tx = 0; tx < tilesX; ++tx) {
-            int x = tx * tileSize;
-            int y = ty * tileSize;
-            int w = std::min(tileSize, width - x);
-            int h = std::min(tileSize, height - y);
+    return computeGrid(sourceImage, nullptr, tileSize, shape, mode, palette);
+}
 
-            cv::Rect region(x, y, w, h);
+MosaicGrid MosaicGenerator::buildGrid(const ImageStatistics& stats, int tileSize,
+                                      TileShape shape, ColorMode mode) {
+    if (!stats.isValid() || tileSize <= 0) {
+        return MosaicGrid();
+    }
+
+    int scaledTileSize = std::max(1, cvRound(tileSize * stats.scale));
+    const std::vector<Utils::Color>& palette = colorPalette.empty() ? stats.palette : colorPalette;
+    return computeGrid(stats.image, &stats, scaledTileSize, shape, mode, palette);
+}
+
+MosaicGrid MosaicGenerator::computeGrid(const cv::Mat& sourceImage, const ImageStatistics* stats, int tileSize,
+                                        TileShape shape, ColorMode mode,
+                                        const std::vector<Utils::Color>& palette) {
+    MosaicGrid grid;
+    grid.width = sourceImage.cols;
+    grid.height = sourceImage.rows;
+    grid.tileSize = tileSize;
+    grid.tilesX = (grid.width + tileSize - 1) / tileSize;
+    grid.tilesY = (grid.height + tileSize - 1) / tileSize;
+    grid.shape = shape;
+    grid.colors.reserve(static_cast<size_t>(grid.tilesX) * grid.tilesY);
+
+    tilesX = grid.tilesX;
+    tilesY = grid.tilesY;
+
+    // Superpixels take their colors from the clustering itself
+    if (shape == TileShape::SUPERPIXEL) {
+        SuperpixelEngine engine;
+        grid.labels = engine.segment(sourceImage, tileSize, grid.colors);
+        if (mode == ColorMode::QUANTIZED && dithering) {
+            ditherColors(grid.colors, grid.tilesX, grid.tilesY, palette);
+        } else if (mode == ColorMode::QUANTIZED) {
+            for (auto& color : grid.colors) {
+                color = findClosestColor(color, palette);
+            }
+        }
+        return grid;
+    }
+
+    // Statistics answer region averages from their summed-area table
+    auto averageColor = [&](const cv::Rect& region) {
+        return stats ? stats->getAverageColor(region) : imageProcessor->getAverageColor(region);
+    };
+
+    for (int ty = 0; ty < grid.tilesY; ++ty) {
+        for (int tx = 0; tx < grid.tilesX; ++tx) {
+            cv::Rect region = grid.tileRect(tx, ty);
             Utils::Color tileColor;
 
             // Determine tile color based on mode
             switch (mode) {
                 case ColorMode::AVERAGE:
-                    tileColor = imageProcessor->getAverageColor(region);
+                    tileColor = averageColor(region);
                     break;
                 case ColorMode::DOMINANT:
                     // For simplicity, use average (can be enhanced with histogram analysis)
-                    tileColor = imageProcessor->getAverageColor(region);
+                    tileColor = averageColor(region);
                     break;
                 case ColorMode::QUANTIZED:
                     {
-                        Utils::Color avgColor = imageProcessor->getAverageColor(region);
-                        tileColor = findClosestColor(avgColor, palette);
+                        // Dithering snaps to the palette after the grid is complete
+                        Utils::Color avgColor = averageColor(region);
+                        tileColor = dithering ? avgColor : findClosestColor(avgColor, palette);
                     }
                     break;
             }
 
-            // Draw the tile
-            cv::Mat tile;
-            cv::Size tileSizeMat(w, h);
-            
-            switch (shape) {
-                case TileShape::SQUARE:
-                    tile = drawSquareTile(tileSizeMat, tileColor);
-                    break;
+            grid.colors.push_back(tileColor);
+        }
+    }
+
+    if (mode == ColorMode::QUANTIZED && dithering) {
+        ditherColors(grid.colors, grid.tilesX, grid.tilesY, palette);
+    }
+
+    // Oriented shapes need the per-tile edge direction
+    if (isOriented(shape)) {
+        grid.orientations = ImageProcessor::computeTileOrientations(sourceImage, tileSize);
+    }
+
+    return grid;
+}
+
+cv::Mat MosaicGenerator::renderGrid(const MosaicGrid& grid) {
+    // One rasterizer for saving, viewing and export, so all three agree pixel for pixel
+    return renderRegion(grid, cv::Rect(0, 0, grid.width, grid.height), 1.0);
+}
+
+cv::Mat MosaicGenerator::renderRegion(const MosaicGrid& grid, const cv::Rect& outputRect, double scale) {
+    if (!grid.isValid() || outputRect.empty() || scale <= 0.0) {
+        return cv::Mat();
+    }
+
+    // Below a few pixels per tile, draw supersampled and box-filter down so
+    // coarse zoom levels average their tiles instead of aliasing
+    const double minTilePixels = 4.0;
+    double tilePixels = grid.tileSize * scale;
+    if (tilePixels < minTilePixels) {
+        int factor = std::min(8, static_cast<int>(std::ceil(minTilePixels / tilePixels)));
+        if (factor > 1) {
+            cv::Rect supersampled(outputRect.x * factor, outputRect.y * factor,
+                                  outputRect.width * factor, outputRect.height * factor);
+            cv::Mat large = drawRegion(grid, supersampled, scale * factor);
+            cv::Mat result;
+            cv::resize(large, result, outputRect.size(), 0, 0, cv::INTER_AREA);
+            return result;
+        }
+    }
+
+    return drawRegion(grid, outputRect, scale);
+}
+
+cv::Mat MosaicGenerator::drawRegion(const MosaicGrid& grid, const cv::Rect& outputRect, double scale) {
+    cv::Mat output = cv::Mat::zeros(outputRect.size(), CV_8UC3);
+    if (grid.shape == TileShape::SUPERPIXEL) {
+        drawSuperpixels(grid, output, outputRect, scale);
+        return output;
+    }
+
+    const int shift = 4;
+    const double fixedScale = 1 << shift;
+    bool oriented = isOriented(grid.shape);
+
+    // Output pixel (u, v) shows mosaic point ((u + outputRect.x) / scale, ...)
+    auto toOutput = [&](double x, double y) {
+        return cv::Point(cvRound(((x * scale) - outputRect.x) * fixedScale),
+                         cvRound(((y * scale) - outputRect.y) * fixedScale));
+    };
+
+    // Corner offsets of the oriented box for every angle bin, computed once
+    // per call instead of once per tile
+    std::vector<OrientedCorners> cornerTable;
+    if (oriented) {
+        cornerTable = orientedCorners(orientedBox(grid.shape, grid.tileSize));
+    }
+
+    // Tiles whose shape can reach the requested rectangle
+    double reach = oriented ? grid.tileSize : 0.0;
+    int firstX = std::max(0, static_cast<int>(std::floor((outputRect.x / scale - reach) / grid.tileSize)));
+    int firstY = std::max(0, static_cast<int>(std::floor((outputRect.y / scale - reach) / grid.tileSize)));
+    int lastX = std::min(grid.tilesX - 1, static_cast<int>(std::floor((outputRect.br().x / scale + reach) / grid.tileSize)));
+    int lastY = std::min(grid.tilesY - 1, static_cast<int>(std::floor((outputRect.br().y / scale + reach) / grid.tileSize)));
+
+    for (int ty = firstY; ty <= lastY; ++ty) {
+        for (int tx = firstX; tx <= lastX; ++tx) {
+            int index = ty * grid.tilesX + tx;
+            cv::Rect cell = grid.tileRect(tx, ty);
+            cv::Scalar color(Utils::colorToVec3b(grid.colors[index]));
+            double cx = cell.x + cell.width / 2;
+            double cy = cell.y + cell.height / 2;
+
+            switch (grid.shape) {
                 case TileShape::CIRCLE:
-                    tile = drawCircleTile(tileSizeMat, tileColor);
+                    {
+                        double radius = std::max(0, std::min(cell.width, cell.height) / 2 - 2) * scale;
+                        cv::circle(output, toOutput(cx, cy), cvRound(radius * fixedScale),
+                                   color, -1, cv::LINE_8, shift);
+                    }
                     break;
                 case TileShape::HEXAGON:
-                    tile = drawHexagonTile(tileSizeMat, tileColor);
+                    {
+                        int radius = std::max(0, std::min(cell.width, cell.height) / 2 - 2);
+                        std::vector<cv::Point> hexagon;
+                        for (int i = 0; i < 6; ++i) {
+                            double angle = i * CV_PI / 3.0;
+                            hexagon.push_back(toOutput(cx + radius * std::cos(angle),
+                                                       cy + radius * std::sin(angle)));
+                        }
+                        cv::fillConvexPoly(output, hexagon, color, cv::LINE_8, shift);
+                    }
+                    break;
+                case TileShape::ORIENTED_SQUARE:
+                case TileShape::ORIENTED_RECTANGLE:
+                    {
+                        const OrientedCorners& corners = cornerTable[orientationBin(grid.orientations[index])];
+                        cv::Point polygon[4];
+                        for (int i = 0; i < 4; ++i) {
+                            polygon[i] = toOutput(cx + corners[i].x, cy + corners[i].y);
+                        }
+                        cv::fillConvexPoly(output, polygon, 4, color, cv::LINE_8, shift);
+                    }
+                    break;
+                default:
+                    {
+                        // Round shared edges identically so squares tile without seams
+                        int x0 = cvRound(cell.x * scale) - outputRect.x;
+                        int y0 = cvRound(cell.y * scale) - outputRect.y;
+                        int x1 = cvRound(cell.br().x * scale) - outputRect.x;
+                        int y1 = cvRound(cell.br().y * scale) - outputRect.y;
+                        cv::Rect target = cv::Rect(x0, y0, x1 - x0, y1 - y0)
+                                        & cv::Rect(0, 0, output.cols, output.rows);
+                        if (!target.empty()) {
+                            output(target).setTo(color);
+                        }
+                    }
                     break;
             }
-
-            // Place tile in mosaic
-            tile.copyTo(mosaic(region));
         }
     }
 
-    return mosaic;
+    return output;
 }
 
 void MosaicGenerator::setColorPalette(const std::vector<Utils::Color>& palette) {
@@ -129,36 +302,231 @@ cv::Mat MosaicGenerator::generatePatternMosaic(int tileSize, const std::vector<c
     return mosaic;
 }
 
-cv::Mat MosaicGenerator::drawSquareTile(const cv::Size& size, const Utils::Color& color) {
-    cv::Mat tile = cv::Mat::zeros(size, CV_8UC3);
-    tile.setTo(Utils::colorToVec3b(color));
-    return tile;
+namespace {
+    // Palette entries that can be nearest to some color in each cell of a
+    // 5-bit-per-channel RGB cube, as a bitmask over palettes of up to 64
+    // colors. The exact nearest entry is then picked from those candidates,
+    // so dithering only changes the diffused error, not the nearest-color rule.
+    std::vector<uint64_t> buildPaletteLookup(const std::vector<Utils::Color>& palette) {
+        if (palette.size() > 64) {
+            return {};
+        }
+
+        std::vector<uint64_t> lookup(32 * 32 * 32);
+
+        // Every color in a cell lies within half a cell diagonal of its center
+        const double reach = 2.0 * std::sqrt(3.0) * 3.5 + 1e-9;
+
+        cv::parallel_for_(cv::Range(0, 32), [&](const cv::Range& range) {
+            std::vector<double> distances(palette.size());
+            for (int r = range.start; r < range.end; ++r) {
+                for (int g = 0; g < 32; ++g) {
+                    for (int b = 0; b < 32; ++b) {
+                        double cr = r * 8 + 3.5, cg = g * 8 + 3.5, cb = b * 8 + 3.5;
+                        double bestDistance = DBL_MAX;
+                        for (size_t i = 0; i < palette.size(); ++i) {
+                            double dr = cr - palette[i].r;
+                            double dg = cg - palette[i].g;
+                            double db = cb - palette[i].b;
+                            distances[i] = std::sqrt(dr * dr + dg * dg + db * db);
+                            bestDistance = std::min(bestDistance, distances[i]);
+                        }
+
+                        uint64_t candidates = 0;
+                        for (size_t i = 0; i < palette.size(); ++i) {
+                            if (distances[i] <= bestDistance + reach) {
+                                candidates |= uint64_t(1) << i;
+                            }
+                        }
+                        lookup[(r << 10) | (g << 5) | b] = candidates;
+                    }
+                }
+            }
+        });
+
+        return lookup;
+    }
+
+    // Exact nearest palette entry among the candidates, first one on ties,
+    // matching findClosestColor
+    int nearestPaletteIndex(const std::vector<Utils::Color>& palette, const std::vector<uint64_t>& lookup,
+                            int r, int g, int b) {
+        uint64_t candidates = lookup.empty() ? ~uint64_t(0) : lookup[((r >> 3) << 10) | ((g >> 3) << 5) | (b >> 3)];
+        int best = 0;
+        int bestDistance = INT_MAX;
+        for (size_t i = 0; i < palette.size(); ++i) {
+            if (i < 64 && !((candidates >> i) & 1)) {
+                continue;
+            }
+            int dr = r - palette[i].r;
+            int dg = g - palette[i].g;
+            int db = b - palette[i].b;
+            int distance = dr * dr + dg * dg + db * db;
+            if (distance < bestDistance) {
+                bestDistance = distance;
+                best = static_cast<int>(i);
+            }
+        }
+        return best;
+    }
+
+    // Round a value held in 1/16 units to the nearest integer
+    inline int roundSixteenths(int value) {
+        return value >= 0 ? (value + 8) >> 4 : -((-value + 8) >> 4);
+    }
+}
+
+void MosaicGenerator::ditherColors(std::vector<Utils::Color>& colors, int tilesX, int tilesY,
+                                   const std::vector<Utils::Color>& palette) {
+    if (palette.empty() || colors.size() != static_cast<size_t>(tilesX) * tilesY) {
+        return;
+    }
+
+    std::vector<uint64_t> lookup = buildPaletteLookup(palette);
+
+    // Error pushed down from the row above, in 1/16 units, RGB per tile
+    std::vector<int> errors(colors.size() * 3, 0);
+
+    // Tiles finished per row. Row y may take tile x once row y - 1 has
+    // finished x + 1, the last tile that diffuses into it, so rows run as a
+    // skewed wavefront with each worker claiming the next row in order.
+    std::vector<std::atomic<int>> progress(tilesY);
+    for (auto& done : progress) {
+        done.store(0, std::memory_order_relaxed);
+    }
+    std::atomic<int> nextRow(0);
+
+    auto ditherRow = [&](int y) {
+        int* rowErrors = &errors[static_cast<size_t>(y) * tilesX * 3];
+        int* belowErrors = y + 1 < tilesY ? rowErrors + tilesX * 3 : nullptr;
+        int carry[3] = {0, 0, 0};
+
+        for (int x = 0; x < tilesX; ++x) {
+            if (y > 0) {
+                int needed = std::min(x + 2, tilesX);
+                while (progress[y - 1].load(std::memory_order_acquire) < needed) {
+                    std::this_thread::yield();
+                }
+            }
+
+            Utils::Color& color = colors[static_cast<size_t>(y) * tilesX + x];
+            int* cell = rowErrors + x * 3;
+            int r = std::clamp(color.r + roundSixteenths(cell[0] + carry[0]), 0, 255);
+            int g = std::clamp(color.g + roundSixteenths(cell[1] + carry[1]), 0, 255);
+            int b = std::clamp(color.b + roundSixteenths(cell[2] + carry[2]), 0, 255);
+
+            const Utils::Color& chosen = palette[nearestPaletteIndex(palette, lookup, r, g, b)];
+            int error[3] = {r - chosen.r, g - chosen.g, b - chosen.b};
+            color = chosen;
+
+            // Floyd-Steinberg weights: 7 right, 3 below-left, 5 below, 1 below-right
+            for (int c = 0; c < 3; ++c) {
+                carry[c] = 7 * error[c];
+                if (belowErrors) {
+                    if (x > 0) {
+                        belowErrors[(x - 1) * 3 + c] += 3 * error[c];
+                    }
+                    belowErrors[x * 3 + c] += 5 * error[c];
+                    if (x + 1 < tilesX) {
+                        belowErrors[(x + 1) * 3 + c] += error[c];
+                    }
+                }
+            }
+
+            progress[y].store(x + 1, std::memory_order_release);
+        }
+    };
+
+    int workers = std::max(1, std::min(cv::getNumThreads(), tilesY));
+    cv::parallel_for_(cv::Range(0, workers), [&](const cv::Range&) {
+        for (int y = nextRow++; y < tilesY; y = nextRow++) {
+            ditherRow(y);
+        }
+    }, workers);
+}
+
+void MosaicGenerator::drawSuperpixels(const MosaicGrid& grid, cv::Mat& output,
+                                      const cv::Rect& outputRect, double scale) {
+    if (grid.labels.empty()) {
+        return;
+    }
+
+    // Nearest-neighbour lookup into the label map; a pixel whose right or
+    // lower neighbour belongs to another superpixel becomes grout
+    std::vector<int> sourceX(output.cols);
+    for (int u = 0; u < output.cols; ++u) {
+        sourceX[u] = std::min(grid.width - 1, static_cast<int>((u + outputRect.x + 0.5) / scale));
+    }
+
+    // Label map entries are offsets into the 3x3 seeds around each pixel's cell
+    auto seedAt = [&](const uchar* row, int x, int y) {
+        return SuperpixelEngine::seedIndex(x, y, row[x], grid.tileSize, grid.tilesX);
+    };
+
+    cv::parallel_for_(cv::Range(0, output.rows), [&](const cv::Range& range) {
+        for (int v = range.start; v < range.end; ++v) {
+            int sy = std::min(grid.height - 1, static_cast<int>((v + outputRect.y + 0.5) / scale));
+            int belowY = std::min(grid.height - 1, sy + 1);
+            const uchar* labelRow = grid.labels.ptr<uchar>(sy);
+            const uchar* belowRow = grid.labels.ptr<uchar>(belowY);
+            cv::Vec3b* outRow = output.ptr<cv::Vec3b>(v);
+
+            for (int u = 0; u < output.cols; ++u) {
+                int sx = sourceX[u];
+                int label = seedAt(labelRow, sx, sy);
+                bool edge = seedAt(labelRow, std::min(grid.width - 1, sx + 1), sy) != label
+                         || seedAt(belowRow, sx, belowY) != label;
+                if (!edge) {
+                    outRow[u] = Utils::colorToVec3b(grid.colors[label]);
+                }
+            }
+        }
+    });
 }
 
-cv::Mat MosaicGenerator::drawCircleTile(const cv::Size& size, const Utils::Color& color) {
-    cv::Mat tile = cv::Mat::zeros(size, CV_8UC3);
-    cv::Point center(size.width / 2, size.height / 2);
-    int radius = std::min(size.width, size.height) / 2 - 2;
-    cv::circle(tile, center, radius, Utils::colorToVec3b(color), -1);
-    return tile;
+bool MosaicGenerator::isOriented(TileShape shape) {
+    return shape == TileShape::ORIENTED_SQUARE || shape == TileShape::ORIENTED_RECTANGLE;
 }
 
-cv::Mat MosaicGenerator::drawHexagonTile(const cv::Size& size, const Utils::Color& color) {
-    cv::Mat tile = cv::Mat::zeros(size, CV_8UC3);
-    cv::Point center(size.width / 2, size.height / 2);
-    int radius = std::min(size.width, size.height) / 2 - 2;
+cv::Size2f MosaicGenerator::orientedBox(TileShape shape, double tileSize) {
+    // Rectangles run along the edge and span a full tile across it, so axis-
+    // aligned runs (including flat regions) cover their cells without gaps;
+    // squares keep a thin grout line like the circles
+    if (shape == TileShape::ORIENTED_RECTANGLE) {
+        return cv::Size2f(static_cast<float>(tileSize * 1.5), static_cast<float>(tileSize));
+    }
+    float side = static_cast<float>(std::max(1.0, tileSize - 2.0));
+    return cv::Size2f(side, side);
+}
 
-    std::vector<cv::Point> hexagon;
-    for (int i = 0; i < 6; ++i) {
-        double angle = i * M_PI / 3.0;
-        hexagon.push_back(cv::Point(
-            center.x + radius * std::cos(angle),
-            center.y + radius * std::sin(angle)
-        ));
+std::vector<MosaicGenerator::OrientedCorners> MosaicGenerator::orientedCorners(const cv::Size2f& box) {
+    // Unit edge directions per bin are shared by every grid and thread
+    static const std::vector<cv::Point2d> directions = [] {
+        std::vector<cv::Point2d> table(ORIENTATION_BINS);
+        for (int bin = 0; bin < ORIENTATION_BINS; ++bin) {
+            double angle = bin * CV_PI / ORIENTATION_BINS;
+            table[bin] = cv::Point2d(std::cos(angle), std::sin(angle));
+        }
+        return table;
+    }();
+
+    std::vector<OrientedCorners> corners(ORIENTATION_BINS);
+    for (int bin = 0; bin < ORIENTATION_BINS; ++bin) {
+        cv::Point2d along = directions[bin] * (0.5 * box.width);
+        cv::Point2d across = cv::Point2d(-directions[bin].y, directions[bin].x) * (0.5 * box.height);
+        corners[bin] = {{-along - across, along - across, along + across, -along + across}};
     }
+    return corners;
+}
+
+int MosaicGenerator::orientationBin(float angle) {
+    return static_cast<int>(std::lround(angle / CV_PI * ORIENTATION_BINS)) % ORIENTATION_BINS;
+}
 
-    cv::fillPoly(tile, std::vector<std::vector<cv::Point>>{hexagon}, Utils::colorToVec3b(color));
-    return tile;
+cv::Rect MosaicGrid::tileRect(int tx, int ty) const {
+    int x = tx * tileSize;
+    int y = ty * tileSize;
+    return cv::Rect(x, y, std::min(tileSize, width - x), std::min(tileSize, height - y));
 }
 
 Utils::Color MosaicGenerator::findClosestColor(const Utils::Color& target, const std::vector<Utils::Color>& palette) {
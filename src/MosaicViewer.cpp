@@ -0,0 +1,271 @@
+#include "../include/MosaicViewer.h"
+#include <QtWidgets/QGraphicsItem>
+#include <QtWidgets/QStyleOptionGraphicsItem>
+#include <QtGui/QPainter>
+#include <QtGui/QWheelEvent>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <iostream>
+
+// Scene item covering the whole mosaic; paints only the exposed view tiles
+class MosaicTileItem : public QGraphicsItem {
+public:
+    MosaicTileItem(MosaicViewer* viewer) : viewer(viewer) {
+        setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+    }
+
+    void setBounds(const QSizeF& size) {
+        prepareGeometryChange();
+        bounds = QRectF(QPointF(0, 0), size);
+    }
+
+    QRectF boundingRect() const override { return bounds; }
+
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget) override;
+
+private:
+    MosaicViewer* viewer;
+    QRectF bounds;
+};
+
+void MosaicTileItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget) {
+    const MosaicGrid* grid = viewer->currentGrid.get();
+    qreal lod = option->levelOfDetailFromTransform(painter->worldTransform());
+    if (!grid || lod <= 0.0) {
+        return;
+    }
+
+    // Level k renders at 2^-k, the coarsest scale that still gives every
+    // device pixel at least one rendered pixel
+    const qreal devicePixels = lod * (widget ? widget->devicePixelRatioF() : viewer->devicePixelRatioF());
+    const int maxLevel = viewer->maxLevel();
+    int level = static_cast<int>(std::floor(std::log2(1.0 / devicePixels) + 1e-6));
+    level = std::clamp(level, MosaicViewer::MIN_LEVEL, maxLevel);
+    viewer->onLevelChanged(level);
+
+    const int tileSize = MosaicViewer::VIEW_TILE_SIZE;
+    const double scale = std::ldexp(1.0, -level);
+    const int levelWidth = static_cast<int>(std::ceil(grid->width * scale));
+    const int levelHeight = static_cast<int>(std::ceil(grid->height * scale));
+
+    QRectF exposed = option->exposedRect.intersected(bounds);
+    if (exposed.isEmpty()) {
+        return;
+    }
+
+    int firstCol = std::max(0, static_cast<int>(std::floor(exposed.left() * scale / tileSize)));
+    int firstRow = std::max(0, static_cast<int>(std::floor(exposed.top() * scale / tileSize)));
+    int lastCol = std::min((levelWidth - 1) / tileSize, static_cast<int>(std::floor(exposed.right() * scale / tileSize)));
+    int lastRow = std::min((levelHeight - 1) / tileSize, static_cast<int>(std::floor(exposed.bottom() * scale / tileSize)));
+
+    for (int row = firstRow; row <= lastRow; ++row) {
+        for (int col = firstCol; col <= lastCol; ++col) {
+            int x = col * tileSize;
+            int y = row * tileSize;
+            QRectF target(x / scale, y / scale,
+                          std::min(tileSize, levelWidth - x) / scale,
+                          std::min(tileSize, levelHeight - y) / scale);
+
+            if (const QImage* image = viewer->requestTile(level, col, row)) {
+                painter->drawImage(target, *image);
+                continue;
+            }
+
+            // Until the tile arrives, stretch a cached coarser level over it
+            bool drawn = false;
+            for (int coarser = level + 1; coarser <= std::min(level + 3, maxLevel) && !drawn; ++coarser) {
+                int steps = coarser - level;
+                int coarseCol = col >> steps;
+                int coarseRow = row >> steps;
+                const QImage* image = viewer->findTile(coarser, coarseCol, coarseRow);
+                if (!image) {
+                    continue;
+                }
+
+                double coarseScale = std::ldexp(1.0, -coarser);
+                QRectF source(target.left() * coarseScale - coarseCol * tileSize,
+                              target.top() * coarseScale - coarseRow * tileSize,
+                              target.width() * coarseScale,
+                              target.height() * coarseScale);
+                painter->drawImage(target, *image, source);
+                drawn = true;
+            }
+
+            if (!drawn) {
+                painter->fillRect(target, QColor(48, 48, 48));
+            }
+        }
+    }
+}
+
+MosaicViewer::MosaicViewer(QWidget* parent)
+    : QGraphicsView(parent),
+      scene(new QGraphicsScene(this)),
+      tileItem(nullptr),
+      generation(0),
+      currentLevel(0) {
+
+    tileItem = new MosaicTileItem(this);
+    scene->addItem(tileItem);
+    setScene(scene);
+
+    tileCache.setMaxCost(CACHE_LIMIT_KB);
+
+    setDragMode(QGraphicsView::ScrollHandDrag);
+    setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
+    setRenderHint(QPainter::SmoothPixmapTransform);
+    setBackgroundBrush(QColor(32, 32, 32));
+}
+
+MosaicViewer::~MosaicViewer() {
+    renderPool.clear();
+    renderPool.waitForDone();
+}
+
+void MosaicViewer::setGrid(const MosaicGrid& grid) {
+    bool sameSize = currentGrid && currentGrid->width == grid.width && currentGrid->height == grid.height;
+
+    // Results still in flight belong to the previous grid and are dropped
+    ++generation;
+    renderPool.clear();
+    pendingTiles.clear();
+    tileCache.clear();
+
+    currentGrid = std::make_shared<const MosaicGrid>(grid);
+    tileItem->setBounds(QSizeF(grid.width, grid.height));
+    scene->setSceneRect(tileItem->boundingRect());
+    tileItem->update();
+
+    if (!sameSize) {
+        fitToView();
+    }
+}
+
+void MosaicViewer::clear() {
+    ++generation;
+    renderPool.clear();
+    pendingTiles.clear();
+    tileCache.clear();
+
+    currentGrid.reset();
+    tileItem->setBounds(QSizeF());
+    scene->setSceneRect(QRectF());
+}
+
+void MosaicViewer::fitToView() {
+    if (currentGrid) {
+        fitInView(tileItem, Qt::KeepAspectRatio);
+    }
+}
+
+void MosaicViewer::wheelEvent(QWheelEvent* event) {
+    if (!currentGrid || event->angleDelta().y() == 0) {
+        QGraphicsView::wheelEvent(event);
+        return;
+    }
+
+    double factor = event->angleDelta().y() > 0 ? 1.25 : 0.8;
+    double zoom = transform().m11() * factor;
+    if (zoom < 1e-4 || zoom > std::ldexp(1.0, -MIN_LEVEL) * 2.0) {
+        return;
+    }
+
+    scale(factor, factor);
+    event->accept();
+}
+
+const QImage* MosaicViewer::requestTile(int level, int col, int row) {
+    quint64 key = tileKey(level, col, row);
+    if (const QImage* image = tileCache.object(key)) {
+        return image;
+    }
+    if (pendingTiles.contains(key)) {
+        return nullptr;
+    }
+    pendingTiles.insert(key);
+
+    double scale = std::ldexp(1.0, -level);
+    int levelWidth = static_cast<int>(std::ceil(currentGrid->width * scale));
+    int levelHeight = static_cast<int>(std::ceil(currentGrid->height * scale));
+    int x = col * VIEW_TILE_SIZE;
+    int y = row * VIEW_TILE_SIZE;
+    cv::Rect outputRect(x, y, std::min(VIEW_TILE_SIZE, levelWidth - x), std::min(VIEW_TILE_SIZE, levelHeight - y));
+
+    std::shared_ptr<const MosaicGrid> grid = currentGrid;
+    int requestGeneration = generation;
+
+    renderPool.start([this, grid, requestGeneration, key, outputRect, scale]() {
+        // A failed render still reports back, with a null image, so the key
+        // leaves pendingTiles and the tile can be requested again
+        QImage image;
+        try {
+            cv::Mat tile = MosaicGenerator::renderRegion(*grid, outputRect, scale);
+            if (!tile.empty()) {
+                cv::Mat rgbMat;
+                cv::cvtColor(tile, rgbMat, cv::COLOR_BGR2RGB);
+                image = QImage(rgbMat.data, rgbMat.cols, rgbMat.rows,
+                               static_cast<int>(rgbMat.step), QImage::Format_RGB888).copy();
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to render view tile: " << e.what() << std::endl;
+        }
+
+        QMetaObject::invokeMethod(this, [this, requestGeneration, key, image]() {
+            onTileReady(requestGeneration, key, image);
+        }, Qt::QueuedConnection);
+    });
+
+    return nullptr;
+}
+
+const QImage* MosaicViewer::findTile(int level, int col, int row) const {
+    return tileCache.object(tileKey(level, col, row));
+}
+
+void MosaicViewer::onTileReady(int requestGeneration, quint64 key, const QImage& image) {
+    if (requestGeneration != generation) {
+        return;
+    }
+
+    pendingTiles.remove(key);
+    if (image.isNull()) {
+        return;
+    }
+
+    int costKB = std::max(1, static_cast<int>(image.sizeInBytes() / 1024));
+    tileCache.insert(key, new QImage(image), costKB);
+    tileItem->update();
+}
+
+void MosaicViewer::onLevelChanged(int level) {
+    if (level == currentLevel) {
+        return;
+    }
+
+    // Queued renders for the old zoom level are no longer worth doing
+    currentLevel = level;
+    renderPool.clear();
+    pendingTiles.clear();
+}
+
+int MosaicViewer::maxLevel() const {
+    if (!currentGrid) {
+        return 0;
+    }
+
+    int level = 0;
+    int extent = std::max(currentGrid->width, currentGrid->height);
+    while (extent > VIEW_TILE_SIZE) {
+        extent = (extent + 1) / 2;
+        ++level;
+    }
+    return level;
+}
+
+quint64 MosaicViewer::tileKey(int level, int col, int row) {
+    return (static_cast<quint64>(level - MIN_LEVEL) << 56)
+         | (static_cast<quint64>(col) << 28)
+         | static_cast<quint64>(row);
+}
@@ -0,0 +1,236 @@
+#include "../include/PaletteBuilder.h"
+#include <opencv2/imgcodecs.hpp>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+    // Uniform draw in (0, 1), safe to take the log of
+    double openUniform(cv::RNG& rng) {
+        return std::max(rng.uniform(0.0, 1.0), 1e-12);
+    }
+}
+
+PaletteBuilder::PaletteBuilder(int paletteSize, int sampleBudget)
+    : paletteSize(std::max(1, paletteSize)),
+      sampleBudget(std::max(this->paletteSize, sampleBudget)),
+      reservoir(this->sampleBudget, 1, CV_8UC3, cv::Scalar::all(0)),
+      sampleCount(0),
+      pixelsSeen(0),
+      imageCount(0),
+      skipWeight(1.0),
+      nextReplacement(0),
+      rng(0x5eed) {
+}
+
+PaletteBuilder::~PaletteBuilder() {
+}
+
+bool PaletteBuilder::addImage(const std::string& filepath) {
+    if (!Utils::isValidImageFile(filepath)) {
+        std::cerr << "Invalid image file format: " << filepath << std::endl;
+        return false;
+    }
+
+    cv::Mat image = cv::imread(filepath, cv::IMREAD_COLOR);
+    if (image.empty()) {
+        std::cerr << "Failed to load image: " << filepath << std::endl;
+        return false;
+    }
+
+    return addImage(image);
+}
+
+bool PaletteBuilder::addImage(const cv::Mat& image) {
+    if (image.empty() || image.type() != CV_8UC3) {
+        return false;
+    }
+
+    samplePixels(image);
+    ++imageCount;
+    refinePalette();
+    return true;
+}
+
+void PaletteBuilder::samplePixels(const cv::Mat& image) {
+    const long long total = static_cast<long long>(image.total());
+    const int cols = image.cols;
+    auto pixelAt = [&](long long index) {
+        return image.at<cv::Vec3b>(static_cast<int>(index / cols), static_cast<int>(index % cols));
+    };
+
+    // Fill the reservoir with the first pixels of the stream
+    long long index = 0;
+    while (sampleCount < sampleBudget && index < total) {
+        reservoir.at<cv::Vec3b>(sampleCount++) = pixelAt(index++);
+        if (sampleCount == sampleBudget) {
+            skipWeight = std::exp(std::log(openUniform(rng)) / sampleBudget);
+            nextReplacement = pixelsSeen + index
+                + static_cast<long long>(std::floor(std::log(openUniform(rng)) / std::log(1.0 - skipWeight)));
+        }
+    }
+
+    // Then jump straight to the next pixel that enters the sample
+    // (Li's Algorithm L), so cost scales with samples taken, not pixels seen
+    if (sampleCount == sampleBudget) {
+        while (nextReplacement < pixelsSeen + total) {
+            long long local = nextReplacement - pixelsSeen;
+            reservoir.at<cv::Vec3b>(rng.uniform(0, sampleBudget)) = pixelAt(local);
+
+            skipWeight *= std::exp(std::log(openUniform(rng)) / sampleBudget);
+            nextReplacement += 1
+                + static_cast<long long>(std::floor(std::log(openUniform(rng)) / std::log(1.0 - skipWeight)));
+        }
+    }
+
+    pixelsSeen += total;
+}
+
+void PaletteBuilder::refinePalette() {
+    if (sampleCount == 0) {
+        return;
+    }
+
+    cv::Mat samples = reservoir.rowRange(0, sampleCount);
+
+    // First image: cluster from scratch
+    if (palette.empty()) {
+        palette = Utils::quantizeColors(samples, std::min(paletteSize, sampleCount));
+        return;
+    }
+
+    // Later images: a few Lloyd iterations warm-started from the current palette
+    std::vector<cv::Vec3f> centers;
+    for (const auto& color : palette) {
+        centers.push_back(cv::Vec3f(color.b, color.g, color.r)); // RGB to BGR
+    }
+
+    const int k = static_cast<int>(centers.size());
+    for (int iteration = 0; iteration < REFINE_ITERATIONS; ++iteration) {
+        std::vector<cv::Vec3d> sums(k, cv::Vec3d(0, 0, 0));
+        std::vector<int> counts(k, 0);
+
+        for (int i = 0; i < sampleCount; ++i) {
+            const cv::Vec3b& pixel = samples.at<cv::Vec3b>(i);
+            int best = 0;
+            float bestDistance = FLT_MAX;
+            for (int c = 0; c < k; ++c) {
+                float d0 = pixel[0] - centers[c][0];
+                float d1 = pixel[1] - centers[c][1];
+                float d2 = pixel[2] - centers[c][2];
+                float distance = d0 * d0 + d1 * d1 + d2 * d2;
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    best = c;
+                }
+            }
+            sums[best] += cv::Vec3d(pixel[0], pixel[1], pixel[2]);
+            ++counts[best];
+        }
+
+        for (int c = 0; c < k; ++c) {
+            if (counts[c] > 0) {
+                centers[c] = cv::Vec3f(sums[c] / static_cast<double>(counts[c]));
+            }
+        }
+    }
+
+    palette.clear();
+    for (const auto& center : centers) {
+        palette.push_back(Utils::Color(
+            static_cast<int>(center[2]), // BGR to RGB
+            static_cast<int>(center[1]),
+            static_cast<int>(center[0])
+        ));
+    }
+}
+
+bool PaletteBuilder::save(const std::string& filepath) const {
+    cv::FileStorage storage(filepath, cv::FileStorage::WRITE);
+    if (!storage.isOpened()) {
+        std::cerr << "Failed to write palette: " << filepath << std::endl;
+        return false;
+    }
+
+    cv::Mat paletteMat(static_cast<int>(palette.size()), 3, CV_32S);
+    for (int i = 0; i < paletteMat.rows; ++i) {
+        paletteMat.at<int>(i, 0) = palette[i].r;
+        paletteMat.at<int>(i, 1) = palette[i].g;
+        paletteMat.at<int>(i, 2) = palette[i].b;
+    }
+
+    // Counters are stored as doubles, which FileStorage handles everywhere.
+    // The 64-bit RNG state would not survive that, so it is written as text.
+    storage << "paletteSize" << paletteSize;
+    storage << "sampleBudget" << sampleBudget;
+    storage << "imageCount" << imageCount;
+    storage << "pixelsSeen" << static_cast<double>(pixelsSeen);
+    storage << "skipWeight" << skipWeight;
+    storage << "nextReplacement" << static_cast<double>(nextReplacement);
+    storage << "rngState" << std::to_string(rng.state);
+    storage << "palette" << paletteMat;
+    storage << "samples" << reservoir.rowRange(0, sampleCount);
+
+    std::cout << "Palette saved successfully: " << filepath
+              << " (" << palette.size() << " colors, " << imageCount << " images)" << std::endl;
+    return true;
+}
+
+bool PaletteBuilder::load(const std::string& filepath) {
+    cv::FileStorage storage(filepath, cv::FileStorage::READ);
+    if (!storage.isOpened()) {
+        std::cerr << "Failed to read palette: " << filepath << std::endl;
+        return false;
+    }
+
+    int storedPaletteSize = 0, storedBudget = 0, storedImages = 0;
+    double storedSeen = 0.0, storedWeight = 1.0, storedNext = 0.0;
+    std::string storedState;
+    cv::Mat paletteMat, samples;
+
+    storage["paletteSize"] >> storedPaletteSize;
+    storage["sampleBudget"] >> storedBudget;
+    storage["imageCount"] >> storedImages;
+    storage["pixelsSeen"] >> storedSeen;
+    storage["skipWeight"] >> storedWeight;
+    storage["nextReplacement"] >> storedNext;
+    storage["rngState"] >> storedState;
+    storage["palette"] >> paletteMat;
+    storage["samples"] >> samples;
+
+    if (storedPaletteSize <= 0 || storedBudget < storedPaletteSize ||
+        (!samples.empty() && (samples.type() != CV_8UC3 || samples.rows > storedBudget)) ||
+        (!paletteMat.empty() && (paletteMat.type() != CV_32S || paletteMat.cols != 3))) {
+        std::cerr << "Invalid palette file: " << filepath << std::endl;
+        return false;
+    }
+
+    paletteSize = storedPaletteSize;
+    sampleBudget = storedBudget;
+    imageCount = storedImages;
+    pixelsSeen = static_cast<long long>(storedSeen);
+    skipWeight = storedWeight;
+    nextReplacement = static_cast<long long>(storedNext);
+
+    // Continue the saved random stream; files without one reseed from the
+    // stream position so sessions do not replay the same draws
+    uint64 state = std::strtoull(storedState.c_str(), nullptr, 10);
+    rng = state != 0 ? cv::RNG(state) : cv::RNG(0x5eed ^ static_cast<uint64>(pixelsSeen));
+
+    reservoir = cv::Mat(sampleBudget, 1, CV_8UC3, cv::Scalar::all(0));
+    sampleCount = samples.rows;
+    if (sampleCount > 0) {
+        samples.copyTo(reservoir.rowRange(0, sampleCount));
+    }
+
+    palette.clear();
+    for (int i = 0; i < paletteMat.rows; ++i) {
+        palette.push_back(Utils::Color(paletteMat.at<int>(i, 0), paletteMat.at<int>(i, 1), paletteMat.at<int>(i, 2)));
+    }
+
+    std::cout << "Palette loaded successfully: " << filepath
+              << " (" << palette.size() << " colors, " << imageCount << " images)" << std::endl;
+    return true;
+}
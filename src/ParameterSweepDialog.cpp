@@ -0,0 +1,202 @@
+#include "../include/ParameterSweepDialog.h"
+#include <QtWidgets/QVBoxLayout>
+#include <QtWidgets/QHBoxLayout>
+#include <QtWidgets/QScrollArea>
+#include <QtGui/QIcon>
+#include <QtGui/QPixmap>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <iterator>
+
+namespace {
+    const int SWEEP_TILE_SIZES[] = {5, 10, 20, 30, 50, 75, 100};
+
+    struct ShapeEntry {
+        TileShape shape;
+        const char* name;
+    };
+
+    const ShapeEntry SWEEP_SHAPES[] = {
+        {TileShape::SQUARE, "Square"},
+        {TileShape::CIRCLE, "Circle"},
+        {TileShape::HEXAGON, "Hexagon"},
+        {TileShape::ORIENTED_SQUARE, "Oriented Square"},
+        {TileShape::ORIENTED_RECTANGLE, "Oriented Rectangle"},
+        {TileShape::SUPERPIXEL, "Superpixel"},
+    };
+}
+
+ParameterSweepDialog::ParameterSweepDialog(ImageProcessor* processor, ColorMode mode, bool dithering,
+                                           const std::vector<Utils::Color>& palette, QWidget* parent)
+    : QDialog(parent),
+      colorMode(mode),
+      dithering(dithering),
+      colorPalette(palette),
+      selectedIndex(-1),
+      cancelled(false) {
+
+    // One statistics pass is shared by every variant on the sheet. Its
+    // k-means palette is only needed for quantized mode without a collection palette.
+    bool needsPalette = mode == ColorMode::QUANTIZED && palette.empty();
+    statistics = processor->computeStatistics(STATISTICS_MAX_SIZE, needsPalette ? STATISTICS_PALETTE_SIZE : 0);
+
+    setupUI();
+    startRendering();
+
+    setWindowTitle("Explore Parameters");
+    resize(1000, 700);
+}
+
+ParameterSweepDialog::~ParameterSweepDialog() {
+    cancelled = true;
+    workerPool.clear();
+    workerPool.waitForDone();
+}
+
+void ParameterSweepDialog::done(int result) {
+    // Drop queued variants as soon as the dialog closes, so the full-resolution
+    // render that usually follows does not compete with the sweep
+    cancelled = true;
+    workerPool.clear();
+    QDialog::done(result);
+}
+
+void ParameterSweepDialog::setupUI() {
+    QVBoxLayout* dialogLayout = new QVBoxLayout(this);
+
+    QWidget* sheet = new QWidget(this);
+    sheetLayout = new QGridLayout(sheet);
+    variantGroup = new QButtonGroup(this);
+    variantGroup->setExclusive(true);
+
+    int columns = static_cast<int>(std::size(SWEEP_TILE_SIZES));
+    for (int col = 0; col < columns; ++col) {
+        QLabel* header = new QLabel(QString("%1 px").arg(SWEEP_TILE_SIZES[col]), sheet);
+        header->setAlignment(Qt::AlignCenter);
+        sheetLayout->addWidget(header, 0, col + 1);
+    }
+
+    int row = 1;
+    for (const auto& entry : SWEEP_SHAPES) {
+        sheetLayout->addWidget(new QLabel(entry.name, sheet), row, 0);
+
+        for (int col = 0; col < columns; ++col) {
+            QPushButton* button = new QPushButton("Rendering...", sheet);
+            button->setCheckable(true);
+            button->setFixedSize(THUMBNAIL_SIZE + 8, THUMBNAIL_SIZE + 8);
+            button->setIconSize(QSize(THUMBNAIL_SIZE, THUMBNAIL_SIZE));
+
+            int index = static_cast<int>(variants.size());
+            variants.push_back({SWEEP_TILE_SIZES[col], entry.shape, entry.name, button});
+            variantGroup->addButton(button, index);
+            sheetLayout->addWidget(button, row, col + 1);
+        }
+        ++row;
+    }
+
+    QScrollArea* scrollArea = new QScrollArea(this);
+    scrollArea->setWidget(sheet);
+    scrollArea->setWidgetResizable(true);
+
+    // Bottom controls
+    QHBoxLayout* bottomLayout = new QHBoxLayout();
+
+    progressBar = new QProgressBar(this);
+    progressBar->setRange(0, static_cast<int>(variants.size()));
+    progressBar->setValue(0);
+
+    selectionLabel = new QLabel("Select a variant", this);
+
+    renderButton = new QPushButton("Render Full Resolution", this);
+    renderButton->setEnabled(false);
+    QPushButton* cancelButton = new QPushButton("Cancel", this);
+
+    bottomLayout->addWidget(progressBar);
+    bottomLayout->addWidget(selectionLabel);
+    bottomLayout->addStretch();
+    bottomLayout->addWidget(renderButton);
+    bottomLayout->addWidget(cancelButton);
+
+    dialogLayout->addWidget(scrollArea);
+    dialogLayout->addLayout(bottomLayout);
+
+    // Connect signals
+    connect(variantGroup, &QButtonGroup::idClicked, this, &ParameterSweepDialog::onVariantClicked);
+    connect(renderButton, &QPushButton::clicked, this, &QDialog::accept);
+    connect(cancelButton, &QPushButton::clicked, this, &QDialog::reject);
+}
+
+void ParameterSweepDialog::startRendering() {
+    if (!statistics.isValid()) {
+        return;
+    }
+
+    for (int i = 0; i < static_cast<int>(variants.size()); ++i) {
+        int tileSize = variants[i].tileSize;
+        TileShape shape = variants[i].shape;
+
+        workerPool.start([this, i, tileSize, shape]() {
+            if (cancelled) {
+                return;
+            }
+
+            // Generators keep per-render state, so each worker owns one.
+            // Nothing may escape a pool thread; a failed variant posts an
+            // empty thumbnail so the sheet and progress bar still complete.
+            QImage thumbnail;
+            try {
+                MosaicGenerator generator(nullptr);
+                generator.setColorPalette(colorPalette);
+                generator.setDithering(dithering);
+                cv::Mat mosaic = generator.generateMosaic(statistics, tileSize, shape, colorMode);
+                thumbnail = toThumbnail(mosaic);
+            } catch (const std::exception& e) {
+                std::cerr << "Failed to render " << tileSize << " px variant: " << e.what() << std::endl;
+            }
+
+            QMetaObject::invokeMethod(this, [this, i, thumbnail]() {
+                setThumbnail(i, thumbnail);
+            }, Qt::QueuedConnection);
+        });
+    }
+}
+
+void ParameterSweepDialog::setThumbnail(int index, const QImage& thumbnail) {
+    QPushButton* button = variants[index].button;
+    if (thumbnail.isNull()) {
+        button->setText("Failed");
+        button->setEnabled(false);
+    } else {
+        button->setText(QString());
+        button->setIcon(QIcon(QPixmap::fromImage(thumbnail)));
+    }
+    progressBar->setValue(progressBar->value() + 1);
+}
+
+void ParameterSweepDialog::onVariantClicked(int index) {
+    selectedIndex = index;
+    const Variant& variant = variants[index];
+    selectionLabel->setText(QString("%1, %2 px").arg(variant.shapeName).arg(variant.tileSize));
+    renderButton->setEnabled(true);
+}
+
+QImage ParameterSweepDialog::toThumbnail(const cv::Mat& mosaic) {
+    if (mosaic.empty()) {
+        return QImage();
+    }
+
+    double scale = std::min(
+        static_cast<double>(THUMBNAIL_SIZE) / mosaic.cols,
+        static_cast<double>(THUMBNAIL_SIZE) / mosaic.rows
+    );
+
+    cv::Mat resized, rgbMat;
+    cv::resize(mosaic, resized, cv::Size(), scale, scale, cv::INTER_AREA);
+    cv::cvtColor(resized, rgbMat, cv::COLOR_BGR2RGB);
+
+    QImage qImage(rgbMat.data, rgbMat.cols, rgbMat.rows,
+                  static_cast<int>(rgbMat.step), QImage::Format_RGB888);
+    return qImage.copy(); // Make a deep copy
+}
@@ -0,0 +1,138 @@
+#include "../include/PyramidExporter.h"
+#include <opencv2/core/utility.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace {
+    struct PyramidTile {
+        int level;
+        int col;
+        int row;
+    };
+
+    struct PyramidLevel {
+        double scale;
+        int width;
+        int height;
+    };
+}
+
+PyramidExporter::PyramidExporter(int tileSize, const std::string& format)
+    : tileSize(std::max(1, tileSize)), format(format) {
+}
+
+PyramidExporter::~PyramidExporter() {
+}
+
+bool PyramidExporter::exportDeepZoom(const MosaicGrid& grid, const std::string& dziPath,
+                                     const ProgressCallback& progress) {
+    namespace fs = std::filesystem;
+
+    if (!grid.isValid()) {
+        std::cerr << "Cannot export empty mosaic" << std::endl;
+        return false;
+    }
+
+    fs::path descriptorPath(dziPath);
+    if (descriptorPath.extension() != ".dzi") {
+        descriptorPath.replace_extension(".dzi");
+    }
+    fs::path tilesRoot = descriptorPath.parent_path() / (descriptorPath.stem().string() + "_files");
+
+    // Level maxLevel is full resolution; each level below halves it down to 1x1
+    int maxDimension = std::max(grid.width, grid.height);
+    int maxLevel = 0;
+    while ((1 << maxLevel) < maxDimension) {
+        ++maxLevel;
+    }
+
+    std::vector<PyramidLevel> levels;
+    std::vector<PyramidTile> tiles;
+    for (int level = 0; level <= maxLevel; ++level) {
+        PyramidLevel info;
+        info.scale = std::ldexp(1.0, level - maxLevel);
+        info.width = std::max(1, static_cast<int>(std::ceil(grid.width * info.scale)));
+        info.height = std::max(1, static_cast<int>(std::ceil(grid.height * info.scale)));
+        levels.push_back(info);
+
+        std::error_code error;
+        fs::create_directories(tilesRoot / std::to_string(level), error);
+        if (error) {
+            std::cerr << "Failed to create directory: " << (tilesRoot / std::to_string(level)).string()
+                      << " (" << error.message() << ")" << std::endl;
+            return false;
+        }
+
+        int cols = (info.width + tileSize - 1) / tileSize;
+        int rows = (info.height + tileSize - 1) / tileSize;
+        for (int row = 0; row < rows; ++row) {
+            for (int col = 0; col < cols; ++col) {
+                tiles.push_back({level, col, row});
+            }
+        }
+    }
+
+    std::vector<int> encodeParams;
+    if (format == "jpg" || format == "jpeg") {
+        encodeParams = {cv::IMWRITE_JPEG_QUALITY, JPEG_QUALITY};
+    }
+
+    const int total = static_cast<int>(tiles.size());
+    std::atomic<int> failures(0);
+    std::atomic<int> completed(0);
+    std::atomic<bool> cancelled(false);
+    cv::parallel_for_(cv::Range(0, total), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end && !cancelled; ++i) {
+            const PyramidTile& tile = tiles[i];
+            const PyramidLevel& level = levels[tile.level];
+
+            int x = tile.col * tileSize;
+            int y = tile.row * tileSize;
+            cv::Rect outputRect(x, y, std::min(tileSize, level.width - x), std::min(tileSize, level.height - y));
+            cv::Mat image = MosaicGenerator::renderRegion(grid, outputRect, level.scale);
+
+            fs::path tilePath = tilesRoot / std::to_string(tile.level)
+                              / (std::to_string(tile.col) + "_" + std::to_string(tile.row) + "." + format);
+            if (image.empty() || !cv::imwrite(tilePath.string(), image, encodeParams)) {
+                ++failures;
+            }
+
+            int done = ++completed;
+            if (progress && !progress(done, total)) {
+                cancelled = true;
+            }
+        }
+    });
+
+    if (cancelled) {
+        std::cerr << "Deep zoom export cancelled: " << descriptorPath.string() << std::endl;
+        return false;
+    }
+
+    if (failures > 0) {
+        std::cerr << "Failed to write " << failures.load() << " pyramid tiles under "
+                  << tilesRoot.string() << std::endl;
+        return false;
+    }
+
+    std::ofstream descriptor(descriptorPath);
+    descriptor << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+               << "<Image xmlns=\"http://schemas.microsoft.com/deepzoom/2008\""
+               << " Format=\"" << format << "\" Overlap=\"0\" TileSize=\"" << tileSize << "\">\n"
+               << "  <Size Width=\"" << grid.width << "\" Height=\"" << grid.height << "\"/>\n"
+               << "</Image>\n";
+
+    if (!descriptor) {
+        std::cerr << "Failed to write descriptor: " << descriptorPath.string() << std::endl;
+        return false;
+    }
+
+    std::cout << "Deep zoom pyramid exported: " << descriptorPath.string()
+              << " (" << maxLevel + 1 << " levels, " << tiles.size() << " tiles)" << std::endl;
+    return true;
+}
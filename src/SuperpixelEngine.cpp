@@ -0,0 +1,192 @@
+#include "../include/SuperpixelEngine.h"
+#include <opencv2/core/utility.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cfloat>
+#include <mutex>
+
+namespace {
+    struct Center {
+        float l, a, b;
+        float x, y;
+    };
+
+    struct ClusterSum {
+        double l = 0, a = 0, b = 0;
+        double x = 0, y = 0;
+        double blue = 0, green = 0, red = 0;
+        long long count = 0;
+    };
+}
+
+SuperpixelEngine::SuperpixelEngine(int iterations, double compactness)
+    : iterations(std::max(1, iterations)), compactness(compactness) {
+}
+
+SuperpixelEngine::~SuperpixelEngine() {
+}
+
+cv::Mat SuperpixelEngine::segment(const cv::Mat& image, int spacing, std::vector<Utils::Color>& meanColors) const {
+    meanColors.clear();
+    if (image.empty() || image.type() != CV_8UC3 || spacing <= 0) {
+        return cv::Mat();
+    }
+
+    const int width = image.cols;
+    const int height = image.rows;
+    const int seedsX = (width + spacing - 1) / spacing;
+    const int seedsY = (height + spacing - 1) / spacing;
+    const int clusterCount = seedsX * seedsY;
+
+    // 8-bit Lab keeps the working set small; rows are widened to float on the fly
+    cv::Mat lab;
+    cv::cvtColor(image, lab, cv::COLOR_BGR2Lab);
+
+    std::vector<Center> centers(clusterCount);
+    for (int sy = 0; sy < seedsY; ++sy) {
+        for (int sx = 0; sx < seedsX; ++sx) {
+            int cx = std::min(width - 1, sx * spacing + spacing / 2);
+            int cy = std::min(height - 1, sy * spacing + spacing / 2);
+            cv::Vec3b pixel = lab.at<cv::Vec3b>(cy, cx);
+            centers[sy * seedsX + sx] = {
+                static_cast<float>(pixel[0]), static_cast<float>(pixel[1]), static_cast<float>(pixel[2]),
+                static_cast<float>(cx), static_cast<float>(cy)
+            };
+        }
+    }
+
+    cv::Mat labels(height, width, CV_8U);
+    std::vector<ClusterSum> sums;
+    const float spatialWeight = static_cast<float>((compactness / spacing) * (compactness / spacing));
+    const int stripes = std::max(1, cv::getNumThreads());
+
+    for (int iteration = 0; iteration < iterations; ++iteration) {
+        // Assignment: each row independently picks the nearest of the 3x3
+        // seeds around every seed cell it crosses
+        cv::parallel_for_(cv::Range(0, height), [&](const cv::Range& range) {
+            std::vector<float> rowBuffer(static_cast<size_t>(width) * 4);
+            float* rowL = rowBuffer.data();
+            float* rowA = rowL + width;
+            float* rowB = rowA + width;
+            float* best = rowB + width;
+
+            for (int y = range.start; y < range.end; ++y) {
+                const cv::Vec3b* labRow = lab.ptr<cv::Vec3b>(y);
+                uchar* labelRow = labels.ptr<uchar>(y);
+                for (int x = 0; x < width; ++x) {
+                    rowL[x] = labRow[x][0];
+                    rowA[x] = labRow[x][1];
+                    rowB[x] = labRow[x][2];
+                }
+                std::fill(best, best + width, FLT_MAX);
+
+                int sy = y / spacing;
+                for (int sx = 0; sx < seedsX; ++sx) {
+                    int x0 = sx * spacing;
+                    int x1 = std::min(width, x0 + spacing);
+
+                    for (int ny = std::max(0, sy - 1); ny <= std::min(seedsY - 1, sy + 1); ++ny) {
+                        for (int nx = std::max(0, sx - 1); nx <= std::min(seedsX - 1, sx + 1); ++nx) {
+                            const uchar offset = static_cast<uchar>((ny - sy + 1) * 3 + (nx - sx + 1));
+                            const Center c = centers[ny * seedsX + nx];
+                            const float dy = y - c.y;
+                            const float rowDistance = spatialWeight * dy * dy;
+
+                            for (int x = x0; x < x1; ++x) {
+                                float dl = rowL[x] - c.l;
+                                float da = rowA[x] - c.a;
+                                float db = rowB[x] - c.b;
+                                float dx = static_cast<float>(x) - c.x;
+                                float d = dl * dl + da * da + db * db + spatialWeight * dx * dx + rowDistance;
+                                bool closer = d < best[x];
+                                best[x] = closer ? d : best[x];
+                                labelRow[x] = closer ? offset : labelRow[x];
+                            }
+                        }
+                    }
+                }
+            }
+        });
+
+        // Update: each stripe sums into accumulators covering only the seed
+        // rows its pixels can reach, then merges them into the totals
+        sums.assign(clusterCount, ClusterSum());
+        std::mutex sumsMutex;
+
+        cv::parallel_for_(cv::Range(0, height), [&](const cv::Range& range) {
+            int firstSeedRow = std::max(0, range.start / spacing - 1);
+            int lastSeedRow = std::min(seedsY - 1, (range.end - 1) / spacing + 1);
+            int offset = firstSeedRow * seedsX;
+            std::vector<ClusterSum> local((lastSeedRow - firstSeedRow + 1) * seedsX);
+
+            for (int y = range.start; y < range.end; ++y) {
+                const cv::Vec3b* labRow = lab.ptr<cv::Vec3b>(y);
+                const cv::Vec3b* bgrRow = image.ptr<cv::Vec3b>(y);
+                const uchar* labelRow = labels.ptr<uchar>(y);
+
+                for (int x = 0; x < width; ++x) {
+                    ClusterSum& sum = local[seedIndex(x, y, labelRow[x], spacing, seedsX) - offset];
+                    sum.l += labRow[x][0];
+                    sum.a += labRow[x][1];
+                    sum.b += labRow[x][2];
+                    sum.x += x;
+                    sum.y += y;
+                    sum.blue += bgrRow[x][0];
+                    sum.green += bgrRow[x][1];
+                    sum.red += bgrRow[x][2];
+                    ++sum.count;
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(sumsMutex);
+            for (size_t i = 0; i < local.size(); ++i) {
+                ClusterSum& total = sums[offset + i];
+                const ClusterSum& part = local[i];
+                total.l += part.l;
+                total.a += part.a;
+                total.b += part.b;
+                total.x += part.x;
+                total.y += part.y;
+                total.blue += part.blue;
+                total.green += part.green;
+                total.red += part.red;
+                total.count += part.count;
+            }
+        }, stripes);
+
+        for (int k = 0; k < clusterCount; ++k) {
+            const ClusterSum& sum = sums[k];
+            if (sum.count == 0) {
+                continue; // Empty clusters keep their previous center
+            }
+            double n = static_cast<double>(sum.count);
+            centers[k] = {
+                static_cast<float>(sum.l / n), static_cast<float>(sum.a / n), static_cast<float>(sum.b / n),
+                static_cast<float>(sum.x / n), static_cast<float>(sum.y / n)
+            };
+        }
+    }
+
+    // The last update pass was taken over the final labels. Empty clusters
+    // own no pixels but still take part in dithering, so they get the color
+    // under their center rather than black.
+    meanColors.resize(clusterCount);
+    for (int k = 0; k < clusterCount; ++k) {
+        const ClusterSum& sum = sums[k];
+        if (sum.count > 0) {
+            double n = static_cast<double>(sum.count);
+            meanColors[k] = Utils::Color(
+                static_cast<int>(sum.red / n),
+                static_cast<int>(sum.green / n),
+                static_cast<int>(sum.blue / n)
+            );
+        } else {
+            int cx = std::clamp(cvRound(centers[k].x), 0, width - 1);
+            int cy = std::clamp(cvRound(centers[k].y), 0, height - 1);
+            const cv::Vec3b& pixel = image.at<cv::Vec3b>(cy, cx);
+            meanColors[k] = Utils::Color(pixel[2], pixel[1], pixel[0]); // BGR to RGB
+        }
+    }
+
+    return labels;
+}
@@ -1,13 +1,25 @@
 #include "../include/UI.h"
+#include "../include/ParameterSweepDialog.h"
+#include "../include/PyramidExporter.h"
+#include "../include/PaletteBuilder.h"
 #include <QtWidgets/QMessageBox>
 #include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+#include <QtCore/QSignalBlocker>
+#include <algorithm>
+#include <exception>
 #include <iostream>
+#include <memory>
 
 MainWindow::MainWindow(QWidget* parent)
     : QMainWindow(parent),
       imageProcessor(new ImageProcessor()),
       mosaicGenerator(nullptr),
-      currentMosaic() {
+      currentGrid(),
+      exportCancelled(false),
+      exportRunning(false),
+      paletteCancelled(false),
+      paletteRunning(false) {
     
     mosaicGenerator = new MosaicGenerator(imageProcessor);
     setupUI();
@@ -17,6 +29,10 @@ MainWindow::MainWindow(QWidget* parent)
 }
 
 MainWindow::~MainWindow() {
+    exportCancelled = true;
+    paletteCancelled = true;
+    exportPool.waitForDone();
+    palettePool.waitForDone();
     delete imageProcessor;
     delete mosaicGenerator;
 }
@@ -33,13 +49,24 @@ void MainWindow::setupUI() {
     loadImageButton = new QPushButton("Load Image", this);
     generateButton = new QPushButton("Generate Mosaic", this);
     saveButton = new QPushButton("Save Mosaic", this);
+    exploreButton = new QPushButton("Explore Parameters...", this);
+    exportButton = new QPushButton("Export Deep Zoom...", this);
+    paletteButton = new QPushButton("Collection Palette...", this);
+    clearPaletteButton = new QPushButton("Clear Palette", this);
     
     generateButton->setEnabled(false);
     saveButton->setEnabled(false);
+    exploreButton->setEnabled(false);
+    exportButton->setEnabled(false);
+    clearPaletteButton->setEnabled(false);
     
     controlLayout->addWidget(loadImageButton);
     controlLayout->addWidget(generateButton);
     controlLayout->addWidget(saveButton);
+    controlLayout->addWidget(exploreButton);
+    controlLayout->addWidget(exportButton);
+    controlLayout->addWidget(paletteButton);
+    controlLayout->addWidget(clearPaletteButton);
     controlLayout->addStretch();
     
     // Parameter controls
@@ -57,6 +84,9 @@ void MainWindow::setupUI() {
     shapeComboBox->addItem("Square");
     shapeComboBox->addItem("Circle");
     shapeComboBox->addItem("Hexagon");
+    shapeComboBox->addItem("Oriented Square");
+    shapeComboBox->addItem("Oriented Rectangle");
+    shapeComboBox->addItem("Superpixel");
     
     colorModeLabel = new QLabel("Color Mode:", this);
     colorModeComboBox = new QComboBox(this);
@@ -64,12 +94,20 @@ void MainWindow::setupUI() {
     colorModeComboBox->addItem("Dominant");
     colorModeComboBox->addItem("Quantized");
     
+    ditherCheckBox = new QCheckBox("Dither", this);
+    ditherCheckBox->setToolTip("Diffuse palette error across tiles in Quantized mode");
+    ditherCheckBox->setEnabled(false);
+    
     paramLayout->addWidget(tileSizeLabel);
     paramLayout->addWidget(tileSizeSpinBox);
     paramLayout->addWidget(shapeLabel);
     paramLayout->addWidget(shapeComboBox);
     paramLayout->addWidget(colorModeLabel);
     paramLayout->addWidget(colorModeComboBox);
+    paramLayout->addWidget(ditherCheckBox);
+    
+    paletteLabel = new QLabel(this);
+    paramLayout->addWidget(paletteLabel);
     paramLayout->addStretch();
     
     // Image display area
@@ -86,12 +124,11 @@ void MainWindow::setupUI() {
     
     QVBoxLayout* mosaicLayout = new QVBoxLayout();
     mosaicLayout->addWidget(new QLabel("Mosaic Preview", this));
-    mosaicImageLabel = new QLabel(this);
-    mosaicImageLabel->setMinimumSize(400, 300);
-    mosaicImageLabel->setAlignment(Qt::AlignCenter);
-    mosaicImageLabel->setStyleSheet("border: 1px solid gray;");
-    mosaicImageLabel->setText("Generate mosaic to preview");
-    mosaicLayout->addWidget(mosaicImageLabel);
+    mosaicViewer = new MosaicViewer(this);
+    mosaicViewer->setMinimumSize(400, 300);
+    mosaicViewer->setStyleSheet("border: 1px solid gray;");
+    mosaicViewer->setToolTip("Scroll to zoom, drag to pan");
+    mosaicLayout->addWidget(mosaicViewer);
     
     imageLayout->addLayout(originalLayout);
     imageLayout->addLayout(mosaicLayout);
@@ -105,12 +142,17 @@ void MainWindow::setupUI() {
     connect(loadImageButton, &QPushButton::clicked, this, &MainWindow::onLoadImage);
     connect(generateButton, &QPushButton::clicked, this, &MainWindow::onGenerateMosaic);
     connect(saveButton, &QPushButton::clicked, this, &MainWindow::onSaveMosaic);
+    connect(exploreButton, &QPushButton::clicked, this, &MainWindow::onExploreParameters);
+    connect(exportButton, &QPushButton::clicked, this, &MainWindow::onExportDeepZoom);
+    connect(paletteButton, &QPushButton::clicked, this, &MainWindow::onBuildCollectionPalette);
+    connect(clearPaletteButton, &QPushButton::clicked, this, &MainWindow::onClearCollectionPalette);
     connect(tileSizeSpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
             this, &MainWindow::onTileSizeChanged);
     connect(shapeComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged),
             this, &MainWindow::onShapeChanged);
     connect(colorModeComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged),
             this, &MainWindow::onColorModeChanged);
+    connect(ditherCheckBox, &QCheckBox::toggled, this, &MainWindow::onDitheringToggled);
 }
 
 void MainWindow::onLoadImage() {
@@ -127,7 +169,14 @@ void MainWindow::onLoadImage() {
     
     if (imageProcessor->loadImage(filepath.toStdString())) {
         updatePreview();
+        
+        // The previous mosaic belongs to the old image
+        currentGrid = MosaicGrid();
+        mosaicViewer->clear();
+        saveButton->setEnabled(false);
+        exportButton->setEnabled(false);
         generateButton->setEnabled(true);
+        exploreButton->setEnabled(true);
     } else {
         QMessageBox::warning(this, "Error", "Failed to load image!");
     }
@@ -142,25 +191,20 @@ void MainWindow::onGenerateMosaic() {
     TileShape shape = static_cast<TileShape>(shapeComboBox->currentIndex());
     ColorMode mode = static_cast<ColorMode>(colorModeComboBox->currentIndex());
     
-    currentMosaic = mosaicGenerator->generateMosaic(tileSize, shape, mode);
+    mosaicGenerator->setDithering(ditherCheckBox->isChecked());
     
-    if (!currentMosaic.empty()) {
-        QImage mosaicQImage = matToQImage(currentMosaic);
-        QPixmap mosaicPixmap = QPixmap::fromImage(mosaicQImage);
-        
-        // Scale for preview if needed
-        if (mosaicPixmap.width() > PREVIEW_MAX_SIZE || mosaicPixmap.height() > PREVIEW_MAX_SIZE) {
-            mosaicPixmap = mosaicPixmap.scaled(PREVIEW_MAX_SIZE, PREVIEW_MAX_SIZE,
-                                              Qt::KeepAspectRatio, Qt::SmoothTransformation);
-        }
-        
-        mosaicImageLabel->setPixmap(mosaicPixmap);
+    // Only the tile grid is kept; the viewer rasterizes what is on screen
+    currentGrid = mosaicGenerator->buildGrid(tileSize, shape, mode);
+    
+    if (currentGrid.isValid()) {
+        mosaicViewer->setGrid(currentGrid);
         saveButton->setEnabled(true);
+        exportButton->setEnabled(!exportRunning);
     }
 }
 
 void MainWindow::onSaveMosaic() {
-    if (currentMosaic.empty()) {
+    if (!currentGrid.isValid()) {
         return;
     }
     
@@ -175,30 +219,290 @@ void MainWindow::onSaveMosaic() {
         return;
     }
     
-    if (imageProcessor->saveImage(currentMosaic, filepath.toStdString())) {
+    cv::Mat mosaic = mosaicGenerator->renderGrid(currentGrid);
+    if (imageProcessor->saveImage(mosaic, filepath.toStdString())) {
         QMessageBox::information(this, "Success", "Mosaic saved successfully!");
     } else {
         QMessageBox::warning(this, "Error", "Failed to save mosaic!");
     }
 }
 
+void MainWindow::onExportDeepZoom() {
+    if (!currentGrid.isValid() || exportRunning) {
+        return;
+    }
+    
+    QString filepath = QFileDialog::getSaveFileName(
+        this,
+        "Export Deep Zoom",
+        QDir::homePath(),
+        "Deep Zoom Image (*.dzi)"
+    );
+    
+    if (filepath.isEmpty()) {
+        return;
+    }
+    
+    // The worker renders from its own copy, so regenerating meanwhile is safe
+    std::shared_ptr<const MosaicGrid> grid = std::make_shared<const MosaicGrid>(currentGrid);
+    std::string dziPath = filepath.toStdString();
+    
+    QProgressDialog* progressDialog = new QProgressDialog("Exporting deep zoom pyramid...", "Cancel", 0, 0, this);
+    progressDialog->setAutoClose(false);
+    progressDialog->setAutoReset(false);
+    progressDialog->setMinimumDuration(0);
+    connect(progressDialog, &QProgressDialog::canceled, this, [this]() {
+        exportCancelled = true;
+    });
+    progressDialog->show();
+    
+    exportCancelled = false;
+    exportRunning = true;
+    exportButton->setEnabled(false);
+    
+    exportPool.start([this, grid, dziPath, progressDialog]() {
+        bool success = false;
+        try {
+            PyramidExporter exporter;
+            success = exporter.exportDeepZoom(*grid, dziPath, [this, progressDialog](int done, int total) {
+                // Post roughly one update per percent rather than one per tile
+                if (done == total || done % std::max(1, total / 100) == 0) {
+                    QMetaObject::invokeMethod(progressDialog, [progressDialog, done, total]() {
+                        progressDialog->setMaximum(total);
+                        progressDialog->setValue(done);
+                    }, Qt::QueuedConnection);
+                }
+                return !exportCancelled;
+            });
+        } catch (const std::exception& e) {
+            std::cerr << "Deep zoom export failed: " << e.what() << std::endl;
+        }
+        
+        QMetaObject::invokeMethod(this, [this, progressDialog, success]() {
+            onExportFinished(progressDialog, success);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void MainWindow::onExportFinished(QProgressDialog* progressDialog, bool success) {
+    progressDialog->close();
+    progressDialog->deleteLater();
+    exportRunning = false;
+    exportButton->setEnabled(currentGrid.isValid());
+    
+    if (exportCancelled) {
+        QMessageBox::information(this, "Cancelled", "Deep zoom export was cancelled.");
+    } else if (success) {
+        QMessageBox::information(this, "Success", "Deep zoom pyramid exported successfully!");
+    } else {
+        QMessageBox::warning(this, "Error", "Failed to export deep zoom pyramid!");
+    }
+}
+
+void MainWindow::onBuildCollectionPalette() {
+    if (paletteRunning) {
+        return;
+    }
+    
+    // An existing palette file is extended; a new one starts a fresh collection
+    QString palettePath = QFileDialog::getSaveFileName(
+        this,
+        "Collection Palette",
+        QDir::homePath(),
+        "Palette Files (*.yml)",
+        nullptr,
+        QFileDialog::DontConfirmOverwrite
+    );
+    
+    if (palettePath.isEmpty()) {
+        return;
+    }
+    
+    std::shared_ptr<PaletteBuilder> builder = std::make_shared<PaletteBuilder>();
+    if (QFileInfo::exists(palettePath) && !builder->load(palettePath.toStdString())) {
+        QMessageBox::warning(this, "Error", "Failed to load palette!");
+        return;
+    }
+    
+    QStringList filepaths = QFileDialog::getOpenFileNames(
+        this,
+        "Add Images to Collection",
+        QDir::homePath(),
+        "Image Files (*.png *.jpg *.jpeg *.bmp)"
+    );
+    
+    // Nothing to add: apply the palette as loaded
+    if (filepaths.isEmpty()) {
+        if (builder->hasPalette()) {
+            applyCollectionPalette(*builder);
+        } else {
+            QMessageBox::warning(this, "Error", "No images could be added to the collection!");
+        }
+        return;
+    }
+    
+    QProgressDialog* progressDialog = new QProgressDialog("Adding images to collection...", "Cancel",
+                                                          0, filepaths.size(), this);
+    progressDialog->setAutoClose(false);
+    progressDialog->setAutoReset(false);
+    progressDialog->setMinimumDuration(0);
+    connect(progressDialog, &QProgressDialog::canceled, this, [this]() {
+        paletteCancelled = true;
+    });
+    progressDialog->show();
+    
+    paletteCancelled = false;
+    paletteRunning = true;
+    paletteButton->setEnabled(false);
+    clearPaletteButton->setEnabled(false);
+    
+    // Decoding, sampling and refinement run per image on the worker
+    std::string palettePathStd = palettePath.toStdString();
+    palettePool.start([this, builder, filepaths, palettePathStd, progressDialog]() {
+        QStringList failedFiles;
+        for (int i = 0; i < filepaths.size() && !paletteCancelled; ++i) {
+            bool added = false;
+            try {
+                added = builder->addImage(filepaths[i].toStdString());
+            } catch (const std::exception& e) {
+                std::cerr << "Failed to add image to collection: " << e.what() << std::endl;
+            }
+            if (!added) {
+                failedFiles.append(QFileInfo(filepaths[i]).fileName());
+            }
+            
+            QMetaObject::invokeMethod(progressDialog, [progressDialog, i]() {
+                progressDialog->setValue(i + 1);
+            }, Qt::QueuedConnection);
+        }
+        
+        // A cancelled batch leaves the palette file untouched
+        bool saved = true;
+        if (!paletteCancelled && failedFiles.size() < filepaths.size()) {
+            saved = builder->save(palettePathStd);
+        }
+        
+        int total = filepaths.size();
+        QMetaObject::invokeMethod(this, [this, progressDialog, builder, total, failedFiles, saved]() {
+            onCollectionPaletteFinished(progressDialog, builder, total, failedFiles, saved);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void MainWindow::onCollectionPaletteFinished(QProgressDialog* progressDialog,
+                                             std::shared_ptr<PaletteBuilder> builder, int total,
+                                             const QStringList& failedFiles, bool saved) {
+    progressDialog->close();
+    progressDialog->deleteLater();
+    paletteRunning = false;
+    paletteButton->setEnabled(true);
+    clearPaletteButton->setEnabled(!mosaicGenerator->getColorPalette().empty());
+    
+    if (paletteCancelled) {
+        QMessageBox::information(this, "Cancelled", "Adding images to the collection was cancelled.");
+        return;
+    }
+    
+    if (!failedFiles.isEmpty()) {
+        QMessageBox::warning(this, "Error",
+                             QString("Failed to add %1 of %2 images to the collection:\n%3")
+                             .arg(failedFiles.size())
+                             .arg(total)
+                             .arg(failedFiles.join("\n")));
+    }
+    
+    if (!builder->hasPalette()) {
+        QMessageBox::warning(this, "Error", "No images could be added to the collection!");
+        return;
+    }
+    
+    if (!saved) {
+        QMessageBox::warning(this, "Error", "Failed to save palette!");
+    }
+    
+    applyCollectionPalette(*builder);
+}
+
+void MainWindow::applyCollectionPalette(const PaletteBuilder& builder) {
+    mosaicGenerator->setColorPalette(builder.getPalette());
+    paletteLabel->setText(QString("Collection palette: %1 colors from %2 images")
+                          .arg(builder.getPalette().size())
+                          .arg(builder.getImageCount()));
+    clearPaletteButton->setEnabled(true);
+    
+    // The shared palette only applies in quantized mode
+    {
+        QSignalBlocker colorModeBlocker(colorModeComboBox);
+        colorModeComboBox->setCurrentIndex(static_cast<int>(ColorMode::QUANTIZED));
+    }
+    ditherCheckBox->setEnabled(true);
+    
+    if (imageProcessor->isImageLoaded() && currentGrid.isValid()) {
+        onGenerateMosaic();
+    }
+}
+
+void MainWindow::onClearCollectionPalette() {
+    // Quantized mode goes back to a palette computed per image
+    mosaicGenerator->setColorPalette({});
+    paletteLabel->clear();
+    clearPaletteButton->setEnabled(false);
+    
+    if (imageProcessor->isImageLoaded() && currentGrid.isValid()) {
+        onGenerateMosaic();
+    }
+}
+
+void MainWindow::onExploreParameters() {
+    if (!imageProcessor->isImageLoaded()) {
+        return;
+    }
+    
+    ColorMode mode = static_cast<ColorMode>(colorModeComboBox->currentIndex());
+    ParameterSweepDialog dialog(imageProcessor, mode, ditherCheckBox->isChecked(),
+                                mosaicGenerator->getColorPalette(), this);
+    
+    if (dialog.exec() != QDialog::Accepted || dialog.selectedTileSize() <= 0) {
+        return;
+    }
+    
+    // Apply the chosen variant without triggering one regeneration per control
+    {
+        QSignalBlocker tileSizeBlocker(tileSizeSpinBox);
+        QSignalBlocker shapeBlocker(shapeComboBox);
+        tileSizeSpinBox->setValue(dialog.selectedTileSize());
+        shapeComboBox->setCurrentIndex(static_cast<int>(dialog.selectedShape()));
+    }
+    
+    onGenerateMosaic();
+}
+
 void MainWindow::onTileSizeChanged(int value) {
     // Auto-regenerate if image is loaded and mosaic exists
-    if (imageProcessor->isImageLoaded() && !currentMosaic.empty()) {
+    if (imageProcessor->isImageLoaded() && currentGrid.isValid()) {
         onGenerateMosaic();
     }
 }
 
 void MainWindow::onShapeChanged(int index) {
     // Auto-regenerate if image is loaded and mosaic exists
-    if (imageProcessor->isImageLoaded() && !currentMosaic.empty()) {
+    if (imageProcessor->isImageLoaded() && currentGrid.isValid()) {
         onGenerateMosaic();
     }
 }
 
 void MainWindow::onColorModeChanged(int index) {
+    ditherCheckBox->setEnabled(static_cast<ColorMode>(index) == ColorMode::QUANTIZED);
+    
+    // Auto-regenerate if image is loaded and mosaic exists
+    if (imageProcessor->isImageLoaded() && currentGrid.isValid()) {
+        onGenerateMosaic();
+    }
+}
+
+void MainWindow::onDitheringToggled(bool checked) {
     // Auto-regenerate if image is loaded and mosaic exists
-    if (imageProcessor->isImageLoaded() && !currentMosaic.empty()) {
+    if (imageProcessor->isImageLoaded() && currentGrid.isValid()) {
         onGenerateMosaic();
     }
 }